@@ -9,6 +9,9 @@
 entry: virtual_ptr
 entry: virtual_shared_ptr
 entry: make_virtual_shared
+entry: virtual_unique_ptr
+entry: make_virtual_unique
+entry: virtual_intrusive_ptr
 hrefs: virtual_ptr-final
 headers: yorel/yomm2/core.hpp, yorel/yomm2/keywords.hpp, yorel/yomm2.hpp
 
@@ -49,6 +52,20 @@ object.
 Virtual shared pointers should be passed by const reference, to avoid excessive
 manipulations of the reference count.
 
+```
+template<class Class, class Policy = default_policy>
+class virtual_ptr<std::unique_ptr<Class>>;
+
+template<class Class, class Policy = default_policy>
+class virtual_ptr<boost::intrusive_ptr<Class>>;
+```
+
+These specializations use `std::unique_ptr` and `boost::intrusive_ptr`
+respectively. Virtual unique pointers can only be moved. When they are passed
+by value to a method, ownership is transferred to the selected definition.
+Virtual intrusive pointers passed by value, and moved into the call, reach the
+definition without touching the reference count.
+
 ## Member functions
 
 |                               |                              |
@@ -77,12 +94,15 @@ manipulations of the reference count.
 |                                                                  |                                                 |
 | ---------------------------------------------------------------- | ----------------------------------------------- |
 | [template@<class Class> virtual_shared_ptr](#virtual_shared_ptr) | alias for `virtual_ptr<std::shared_ptr<Class>>` |
+| [template@<class Class> virtual_unique_ptr](#virtual_unique_ptr) | alias for `virtual_ptr<std::unique_ptr<Class>>` |
+| [template@<class Class> virtual_intrusive_ptr](#virtual_intrusive_ptr) | alias for `virtual_ptr<boost::intrusive_ptr<Class>>` |
 
 ## Non member functions
 
 |                                                                      |                                                 |
 | -------------------------------------------------------------------- | ----------------------------------------------- |
 | [template@<class Class> make_virtual_shared()](#make_virtual_shared) | creates an object and returns a new virtual_ptr |
+| [template@<class Class> make_virtual_unique()](#make_virtual_unique) | creates an object and returns a new virtual_ptr |
 
 ## virtual_ptr
 
@@ -165,6 +185,25 @@ it. No hash table lookup is performed.
 
 This construct is always safe to use, even with non-polymorphic types.
 
+## virtual_unique_ptr
+
+`virtual_unique_ptr<Class>` is an alias for
+`virtual_ptr<std::unique_ptr<Class>>`.
+
+## make_virtual_unique
+
+|                                                   |     |
+| ------------------------------------------------- | --- |
+| `template@<class Class$gt; make_virtual_unique()` |     |
+
+Constructs an object, using `std::make_unique`, and return a `virtual_ptr` to
+it. No hash table lookup is performed.
+
+## virtual_intrusive_ptr
+
+`virtual_intrusive_ptr<Class>` is an alias for
+`virtual_ptr<boost::intrusive_ptr<Class>>`.
+
 # Discussion
 
 Calls to methods through a `virtual_ptr` are almost as efficient as virtual
@@ -3,6 +3,8 @@
 
 #include <functional>
 #include <memory>
+#include <tuple>
+#include <vector>
 
 #include <boost/assert.hpp>
 
@@ -39,6 +41,25 @@ using virtual_ptr_policy = std::conditional_t<
 template<typename Key, typename Signature, class Policy = YOMM2_DEFAULT_POLICY>
 struct method;
 
+// For a method in a closed world - with a policy that has the 'closed_rtti'
+// facet - a 'std::tuple' named 'functions', containing pointers to the
+// functions that define the method. Calls are dispatched through a table
+// built at compile time, without calling 'update'.
+template<class Method>
+struct closed_definitions;
+
+namespace detail {
+
+template<class Method, typename = void>
+struct has_closed_definitions : std::false_type {};
+
+template<class Method>
+struct has_closed_definitions<
+    Method, std::void_t<decltype(closed_definitions<Method>::functions)>>
+    : std::true_type {};
+
+} // namespace detail
+
 template<typename Key, typename R, class Policy, typename... A>
 struct method<Key, R(A...), Policy> : detail::method_info {
     using self_type = method;
@@ -56,7 +77,7 @@ struct method<Key, R(A...), Policy> : detail::method_info {
     static constexpr auto arity = detail::arity<A...>;
     static_assert(arity > 0, "method must have at least one virtual argument");
 
-    static std::size_t slots_strides[2 * arity - 1];
+    static std::size_t slots_strides[2 * arity + 1];
     // Slots followed by strides. No stride for first virtual argument.
     // For 1-method: the offset of the method in the method table, which
     // contains a pointer to a function.
@@ -64,6 +85,15 @@ struct method<Key, R(A...), Policy> : detail::method_info {
     // method table, which contains a pointer to the corresponding cell in
     // the dispatch table, followed by the offset of the second argument and
     // the stride in the second dimension, etc.
+    // Then the function to call if it does not depend on the arguments, or
+    // zero, and a mask of the virtual arguments that do not take part in the
+    // resolution.
+
+    // Not with 'runtime_checks', which looks at all the arguments, or with
+    // 'call_counter', which counts the calls per class.
+    static constexpr bool skip_dead_dimensions =
+        !Policy::template has_facet<policy::runtime_checks> &&
+        !Policy::template has_facet<policy::call_counter>;
 
     static method fn;
 
@@ -80,6 +110,21 @@ struct method<Key, R(A...), Policy> : detail::method_info {
     template<class Error>
     void check_static_offset(std::size_t actual, std::size_t expected) const;
 
+    template<typename MethodArgList, typename ArgType, typename... MoreArgTypes>
+    const std::uintptr_t*
+    guard_vptr(const ArgType& arg, const MoreArgTypes&... more_args) const;
+
+    void
+    check_static_guard(const std::uintptr_t* vtbl, std::uintptr_t pf) const;
+
+    template<typename MethodArgList, typename ArgType, typename... MoreArgTypes>
+    void dispatch_vptrs(
+        const std::uintptr_t** vptrs, const ArgType& arg,
+        const MoreArgTypes&... more_args) const;
+
+    void
+    check_dispatch_function(std::uintptr_t expected, std::uintptr_t pf) const;
+
     template<typename MethodArgList, typename ArgType, typename... MoreArgTypes>
     std::uintptr_t
     resolve_uni(const ArgType& arg, const MoreArgTypes&... more_args) const;
@@ -92,14 +137,59 @@ struct method<Key, R(A...), Policy> : detail::method_info {
         std::size_t VirtualArg, typename MethodArgList, typename ArgType,
         typename... MoreArgTypes>
     std::uintptr_t resolve_multi_next(
-        const std::uintptr_t* dispatch, const ArgType& arg,
+        const detail::dispatch_cell<Policy>* dispatch, const ArgType& arg,
         const MoreArgTypes&... more_args) const;
 
     template<typename... ArgType>
     function_pointer_type resolve(const ArgType&... args) const;
 
+    // With 'concurrent_update': the slots and strides in the image used by
+    // the current call.
+    const std::size_t* installed_slots_strides() const;
+
+    template<typename MethodArgList, typename ArgType, typename... MoreArgTypes>
+    std::size_t
+    closed_cell(const ArgType& arg, const MoreArgTypes&... more_args) const;
+
+    // With 'closed_rtti': the functions selected at compile time for each
+    // combination of classes, in '.rodata'.
+    template<typename = void>
+    struct closed_table;
+
     return_type operator()(detail::remove_virtual<A>... args) const;
 
+    // Call the method for each object in a range, passing the same extra
+    // arguments to each call. Objects are processed in blocks: the method
+    // table entries for a whole block are located and prefetched before the
+    // first call is made, so the memory accesses of consecutive objects
+    // overlap instead of waiting on each other.
+    static constexpr std::size_t batch_size = 16;
+
+    template<class Range, typename... MoreArgs>
+    void for_each(Range&& range, MoreArgs&&... more_args) const;
+
+    // Call the method for each tuple of arguments in a range. All the calls
+    // are resolved first, then they are made grouped by definition, thus
+    // keeping indirect branches predictable. Calls to the same definition
+    // are made in range order, but calls to different definitions are not.
+    template<class Range>
+    void apply_grouped(Range&& range) const;
+
+    // A call site cache that remembers the functions selected for the last
+    // 'Size' combinations of dynamic types, and checks them before
+    // performing a full resolution. The cache is flushed when the dispatch
+    // tables are installed again, e.g. by 'update'. It is not thread-safe:
+    // use one cache per thread, e.g. a 'thread_local' object.
+    template<std::size_t Size = 4>
+    class inline_cache;
+
+    // A function resolved once for the dynamic types of a set of arguments,
+    // to be called repeatedly with arguments of the same dynamic types, e.g.
+    // in a loop. If the dispatch tables have been installed again since the
+    // function was resolved, it is resolved again, for the arguments of the
+    // call.
+    class bound_call;
+
     static BOOST_NORETURN return_type
     not_implemented_handler(detail::remove_virtual<A>... args);
     static BOOST_NORETURN return_type
@@ -121,6 +211,13 @@ struct method<Key, R(A...), Policy> : detail::method_info {
 
             info.method = &fn;
             info.type = Policy::template static_type<decltype(Function)>();
+
+            if constexpr (!Policy::template has_facet<
+                              policy::deferred_static_rtti>) {
+                // Deferred ids are resolved for classes only.
+                info.registrar = Policy::template static_type<add_function>();
+            }
+
             info.next = reinterpret_cast<void**>(next);
             using parameter_types =
                 detail::parameter_type_list_t<decltype(Function)>;
@@ -176,6 +273,94 @@ struct method<Key, R(A...), Policy> : detail::method_info {
 template<typename Key, typename R, class Policy, typename... A>
 method<Key, R(A...), Policy> method<Key, R(A...), Policy>::fn;
 
+template<typename Key, typename R, class Policy, typename... A>
+template<std::size_t Size>
+class method<Key, R(A...), Policy>::inline_cache {
+    static_assert(Size > 0, "inline_cache must have at least one entry");
+
+    std::size_t epoch = 0;
+    std::size_t size = 0;
+    std::size_t victim = 0;
+    type_id keys[Size][arity];
+    function_pointer_type functions[Size];
+
+    template<typename ArgType, typename T>
+    static void collect_key(type_id*& key_iter, const T& arg) {
+        using namespace detail;
+
+        if constexpr (is_virtual_ptr<ArgType>) {
+            *key_iter++ = reinterpret_cast<type_id>(arg._vptr());
+        } else if constexpr (is_virtual<ArgType>::value) {
+            *key_iter++ = get_tip<Policy, ArgType>(arg);
+        }
+    }
+
+  public:
+    return_type operator()(detail::remove_virtual<A>... args) {
+        using namespace detail;
+
+        if (epoch != Policy::epoch) {
+            epoch = Policy::epoch;
+            size = 0;
+            victim = 0;
+        }
+
+        type_id key[arity];
+        auto key_iter = key;
+        (..., collect_key<A>(key_iter, args));
+
+        for (std::size_t i = 0; i < size; ++i) {
+            if (std::equal(key, key + arity, keys[i])) {
+                return functions[i](std::forward<remove_virtual<A>>(args)...);
+            }
+        }
+
+        auto pf = fn.resolve(argument_traits<Policy, A>::rarg(args)...);
+        std::copy_n(key, arity, keys[victim]);
+        functions[victim] = pf;
+
+        if (size < Size) {
+            ++size;
+        }
+
+        victim = (victim + 1) % Size;
+
+        return pf(std::forward<remove_virtual<A>>(args)...);
+    }
+};
+
+template<typename Key, typename R, class Policy, typename... A>
+class method<Key, R(A...), Policy>::bound_call {
+    std::size_t epoch;
+    function_pointer_type pf;
+
+  public:
+    template<typename... ArgType>
+    explicit bound_call(const ArgType&... args)
+        : epoch(Policy::epoch),
+          pf(fn.resolve(detail::argument_traits<Policy, A>::rarg(args)...)) {
+    }
+
+    bool is_current() const noexcept {
+        return epoch == Policy::epoch;
+    }
+
+    function_pointer_type function() const noexcept {
+        return pf;
+    }
+
+    return_type operator()(detail::remove_virtual<A>... args) {
+        using namespace detail;
+
+        if (epoch != Policy::epoch) {
+            epoch = Policy::epoch;
+            pf = fn.resolve(argument_traits<Policy, A>::rarg(args)...);
+        }
+
+        return pf(std::forward<remove_virtual<A>>(args)...);
+    }
+};
+
 template<typename Key, typename R, class Policy, typename... A>
 template<typename Container>
 typename method<Key, R(A...), Policy>::next_type
@@ -218,31 +403,29 @@ class virtual_ptr {
     static constexpr bool is_indirect =
         Policy::template has_facet<policy::indirect_vptr>;
 
+    static constexpr bool is_compact =
+        Policy::template has_facet<policy::compact_vptr> && !IsSmartPtr;
+
     using vptr_type = std::conditional_t<
         is_indirect, std::uintptr_t const* const*, std::uintptr_t const*>;
 
-    Box obj;
-    vptr_type vptr;
+    detail::virtual_ptr_storage<Policy, Box, vptr_type, is_compact> storage;
 
     template<typename Other>
     void box(Other&& value) {
         if constexpr (IsSmartPtr) {
-            if constexpr (std::is_rvalue_reference_v<Other>) {
-                obj = std::move(value);
-            } else {
-                obj = value;
-            }
+            storage.obj(std::forward<Other>(value));
         } else {
             static_assert(std::is_lvalue_reference_v<Other>);
-            obj = &value;
+            storage.obj(&value);
         }
     }
 
-    auto& unbox() const {
+    decltype(auto) unbox() const {
         if constexpr (IsSmartPtr) {
-            return obj;
+            return storage.obj();
         } else {
-            return *obj;
+            return *storage.obj();
         }
     }
 
@@ -252,66 +435,79 @@ class virtual_ptr {
 
     template<class Other>
     virtual_ptr(Other&& other) {
-        box(other);
-
         using namespace policy;
         using namespace detail;
 
+        using other_traits =
+            virtual_traits<Policy, const std::remove_reference_t<Other>&>;
+        using other_type = typename other_traits::polymorphic_type;
+
         static_assert(
-            std::is_polymorphic_v<polymorphic_type<
-                Policy, const std::remove_reference_t<Other>&>>,
-            "use 'final' if intended");
-
-        auto dynamic_id =
-            Policy::dynamic_type(virtual_traits<Policy, Other&>::rarg(other));
-        auto static_id = Policy::template static_type<
-            typename virtual_traits<Policy, Other&>::polymorphic_type>();
-
-        if (dynamic_id == static_id) {
-            if constexpr (has_facet<Policy, indirect_vptr>) {
-                vptr = &Policy::template static_vptr<
-                    typename detail::virtual_traits<
-                        Policy, Other&>::polymorphic_type>;
-            } else {
-                vptr = Policy::template static_vptr<
-                    typename virtual_traits<Policy, Other&>::polymorphic_type>;
-            }
+            std::is_polymorphic_v<other_type>, "use 'final' if intended");
+
+        vptr_type vptr;
+
+        if constexpr (has_facet<Policy, intrusive_vptr>) {
+            const typename virtual_ptr_traits<Class, Policy>::polymorphic_type&
+                object = other_traits::rarg(other);
+            vptr = object.yomm2_vptr();
         } else {
-            auto index = dynamic_id;
 
-            if constexpr (has_facet<Policy, type_hash>) {
-                index = Policy::hash_type_id(index);
-            }
+            auto dynamic_id = Policy::dynamic_type(other_traits::rarg(other));
+            auto static_id = Policy::template static_type<other_type>();
 
-            if constexpr (has_facet<Policy, indirect_vptr>) {
-                vptr = Policy::indirect_vptrs[index];
+            if (dynamic_id == static_id) {
+                if constexpr (has_facet<Policy, indirect_vptr>) {
+                    vptr = &Policy::template static_vptr<other_type>;
+                } else {
+                    vptr = Policy::template static_vptr<other_type>;
+                }
             } else {
-                vptr = Policy::vptrs[index];
+                auto index = dynamic_id;
+
+                if constexpr (has_facet<Policy, type_hash>) {
+                    index = Policy::hash_type_id(index);
+                }
+
+                if constexpr (has_facet<Policy, indirect_vptr>) {
+                    vptr = Policy::indirect_vptrs[index];
+                } else {
+                    vptr = Policy::vptrs[index];
+                }
             }
         }
+
+        // smart pointers are moved in if possible, the object is not needed
+        // past this point
+        if constexpr (IsSmartPtr) {
+            box(std::forward<Other>(other));
+        } else {
+            box(other);
+        }
+
+        storage.vptr(vptr);
     }
 
     template<class Other>
-    virtual_ptr(virtual_ptr<Other, Policy>& other)
-        : obj(other.obj), vptr(other.vptr) {
+    virtual_ptr(virtual_ptr<Other, Policy>& other) : storage(other.storage) {
     }
 
     template<class Other>
     virtual_ptr(const virtual_ptr<Other, Policy>& other)
-        : obj(other.obj), vptr(other.vptr) {
+        : storage(other.storage) {
     }
 
     template<class Other>
     virtual_ptr(virtual_ptr<Other, Policy>&& other)
-        : obj(std::move(other.obj)), vptr(other.vptr) {
+        : storage(std::move(other.storage)) {
     }
 
-    auto get() const noexcept {
-        return obj;
+    decltype(auto) get() const noexcept {
+        return storage.obj();
     }
 
     auto operator->() const noexcept {
-        return get();
+        return &*get();
     }
 
     decltype(auto) operator*() const noexcept {
@@ -323,7 +519,8 @@ class virtual_ptr {
         using namespace detail;
         using namespace policy;
 
-        using other_virtual_traits = virtual_traits<Policy, Other>;
+        using other_virtual_traits =
+            virtual_traits<Policy, const std::remove_reference_t<Other>&>;
         using polymorphic_type =
             typename other_virtual_traits::polymorphic_type;
 
@@ -350,35 +547,62 @@ class virtual_ptr {
         }
 
         virtual_ptr result;
-        result.box(obj);
-        result.vptr = vptr;
+
+        if constexpr (IsSmartPtr) {
+            result.box(std::forward<Other>(obj));
+        } else {
+            result.box(obj);
+        }
+
+        result.storage.vptr(vptr);
 
         return result;
     }
 
     template<typename Other>
-    auto cast() const {
+    auto cast() const& {
         using namespace detail;
         std::remove_cv_t<std::remove_reference_t<Other>> result;
-        result.vptr = vptr;
+        result.storage.vptr(storage.vptr());
 
         if constexpr (IsSmartPtr) {
-            result.obj =
-                virtual_ptr_traits<Class, Policy>::template cast<Other>(obj);
+            result.storage.obj(
+                virtual_ptr_traits<Class, Policy>::template cast<Other>(
+                    storage.obj()));
         } else {
-            result.obj =
-                &optimal_cast<Policy, typename Other::element_type&>(*obj);
+            result.storage.obj(
+                &optimal_cast<Policy, typename Other::element_type&>(
+                    *storage.obj()));
         }
 
         return result;
     }
 
+    // move the smart pointer to the result, e.g. for unique_ptr
+    template<typename Other>
+    auto cast() && {
+        using namespace detail;
+
+        if constexpr (IsSmartPtr) {
+            std::remove_cv_t<std::remove_reference_t<Other>> result;
+            result.storage.vptr(storage.vptr());
+            result.storage.obj(
+                virtual_ptr_traits<Class, Policy>::template cast<Other>(
+                    storage.move_obj()));
+
+            return result;
+        } else {
+            return static_cast<const virtual_ptr&>(*this)
+                .template cast<Other>();
+        }
+    }
+
     // consider as private, public for tests only
     auto _vptr() const noexcept {
         if constexpr (is_indirect) {
-            return *vptr;
+            return *storage.vptr();
         } else {
-            return vptr;
+            return storage.vptr();
         }
     }
 
@@ -398,6 +622,18 @@ inline auto make_virtual_shared() {
         std::make_shared<detail::virtual_ptr_class<Class>>());
 }
 
+template<class Class, class Policy = YOMM2_DEFAULT_POLICY>
+using virtual_unique_ptr = virtual_ptr<std::unique_ptr<Class>, Policy>;
+
+template<class Class, class Policy = YOMM2_DEFAULT_POLICY>
+inline auto make_virtual_unique() {
+    return virtual_unique_ptr<Class, Policy>::final(
+        std::make_unique<detail::virtual_ptr_class<Class>>());
+}
+
+template<class Class, class Policy = YOMM2_DEFAULT_POLICY>
+using virtual_intrusive_ptr = virtual_ptr<boost::intrusive_ptr<Class>, Policy>;
+
 template<class Policy, class Class>
 inline auto final_virtual_ptr(Class& obj) {
     return virtual_ptr<Class, Policy>::final(obj);
@@ -408,6 +644,207 @@ inline auto final_virtual_ptr(Class& obj) {
     return virtual_ptr<Class>::final(obj);
 }
 
+// -----------------------------------------------------------------------------
+// with_vptr
+
+// Mixin for policies with the 'intrusive_vptr' facet. The root of a hierarchy
+// derives from 'with_vptr<Class>' or 'with_vptr<Class, Policy>', which stores
+// the vptr in the object. Derived classes also derive from
+// 'with_vptr<Class, Bases...>', which stamps the vptr of 'Class' into each of
+// its direct 'Bases' after they are constructed, and restores it when they
+// are destroyed.
+//
+// Unless the policy has the 'indirect_vptr' facet, objects created before
+// 'update' hold stale vptrs, and must not be used to call methods afterwards.
+
+template<class Class, class... Bases>
+class with_vptr;
+
+namespace detail {
+
+template<class Policy>
+using intrusive_vptr_type = std::conditional_t<
+    policy::has_facet<Policy, policy::indirect_vptr>,
+    const std::uintptr_t* const*, const std::uintptr_t*>;
+
+template<class Policy, class Class>
+auto static_intrusive_vptr() -> intrusive_vptr_type<Policy> {
+    if constexpr (policy::has_facet<Policy, policy::indirect_vptr>) {
+        return &Policy::template static_vptr<Class>;
+    } else {
+        return Policy::template static_vptr<Class>;
+    }
+}
+
+template<class Class, bool IsRoot, class... Bases>
+class with_vptr_aux;
+
+template<class Class, class Policy>
+class with_vptr_aux<Class, true, Policy> {
+    template<class, bool, class...>
+    friend class with_vptr_aux;
+
+    intrusive_vptr_type<Policy> yomm2_vptr_;
+
+  protected:
+    with_vptr_aux() : yomm2_vptr_(static_intrusive_vptr<Policy, Class>()) {
+    }
+
+    // the vptr identifies the dynamic type, never copy it
+    with_vptr_aux(const with_vptr_aux&) : with_vptr_aux() {
+    }
+
+    with_vptr_aux& operator=(const with_vptr_aux&) {
+        return *this;
+    }
+
+    ~with_vptr_aux() = default;
+
+  public:
+    using yomm2_policy = Policy;
+
+    auto yomm2_vptr() const noexcept {
+        return yomm2_vptr_;
+    }
+};
+
+template<class Class, class... Bases>
+class with_vptr_aux<Class, false, Bases...> {
+    template<class Stamp, class Base>
+    void stamp() {
+        Base& base = *static_cast<Class*>(this);
+        base.yomm2_vptr_ = static_intrusive_vptr<
+            typename Base::yomm2_policy, Stamp>();
+    }
+
+  protected:
+    with_vptr_aux() {
+        (stamp<Class, Bases>(), ...);
+    }
+
+    with_vptr_aux(const with_vptr_aux&) : with_vptr_aux() {
+    }
+
+    with_vptr_aux& operator=(const with_vptr_aux&) {
+        return *this;
+    }
+
+    ~with_vptr_aux() {
+        (stamp<Bases, Bases>(), ...);
+    }
+};
+
+template<class Class, class... Bases>
+struct with_vptr_base {
+    using type = with_vptr_aux<Class, false, Bases...>;
+};
+
+template<class Class>
+struct with_vptr_base<Class> {
+    using type = with_vptr_aux<Class, true, YOMM2_DEFAULT_POLICY>;
+};
+
+template<class Class, class Base>
+struct with_vptr_base<Class, Base> {
+    using type = with_vptr_aux<Class, is_policy<Base>, Base>;
+};
+
+} // namespace detail
+
+template<class Class, class... Bases>
+class with_vptr : public detail::with_vptr_base<Class, Bases...>::type {};
+
+// -----------------------------------------------------------------------------
+// with_type_id
+
+// Mixin for policies with the 'dense_rtti' facet. It is used like 'with_vptr',
+// but stores the dense type id of the object's class instead of its vptr.
+
+template<class Class, class... Bases>
+class with_type_id;
+
+namespace detail {
+
+template<class Class, bool IsRoot, class... Bases>
+class with_type_id_aux;
+
+template<class Class, class Policy>
+class with_type_id_aux<Class, true, Policy> {
+    template<class, bool, class...>
+    friend class with_type_id_aux;
+
+    type_id yomm2_type_id_;
+
+  protected:
+    with_type_id_aux()
+        : yomm2_type_id_(Policy::template static_type<Class>()) {
+    }
+
+    // the id identifies the dynamic type, never copy it
+    with_type_id_aux(const with_type_id_aux&) : with_type_id_aux() {
+    }
+
+    with_type_id_aux& operator=(const with_type_id_aux&) {
+        return *this;
+    }
+
+    ~with_type_id_aux() = default;
+
+  public:
+    using yomm2_policy = Policy;
+
+    auto yomm2_type_id() const noexcept {
+        return yomm2_type_id_;
+    }
+};
+
+template<class Class, class... Bases>
+class with_type_id_aux<Class, false, Bases...> {
+    template<class Stamp, class Base>
+    void stamp() {
+        Base& base = *static_cast<Class*>(this);
+        base.yomm2_type_id_ =
+            Base::yomm2_policy::template static_type<Stamp>();
+    }
+
+  protected:
+    with_type_id_aux() {
+        (stamp<Class, Bases>(), ...);
+    }
+
+    with_type_id_aux(const with_type_id_aux&) : with_type_id_aux() {
+    }
+
+    with_type_id_aux& operator=(const with_type_id_aux&) {
+        return *this;
+    }
+
+    ~with_type_id_aux() {
+        (stamp<Bases, Bases>(), ...);
+    }
+};
+
+template<class Class, class... Bases>
+struct with_type_id_base {
+    using type = with_type_id_aux<Class, false, Bases...>;
+};
+
+template<class Class>
+struct with_type_id_base<Class> {
+    using type = with_type_id_aux<Class, true, YOMM2_DEFAULT_POLICY>;
+};
+
+template<class Class, class Base>
+struct with_type_id_base<Class, Base> {
+    using type = with_type_id_aux<Class, is_policy<Base>, Base>;
+};
+
+} // namespace detail
+
+template<class Class, class... Bases>
+class with_type_id
+    : public detail::with_type_id_base<Class, Bases...>::type {};
+
 // -----------------------------------------------------------------------------
 // definitions
 
@@ -429,7 +866,7 @@ method<Key, R(A...), Policy>::method() {
 }
 
 template<typename Key, typename R, class Policy, typename... A>
-std::size_t method<Key, R(A...), Policy>::slots_strides[2 * arity - 1];
+std::size_t method<Key, R(A...), Policy>::slots_strides[2 * arity + 1];
 
 template<typename Key, typename R, class Policy, typename... A>
 method<Key, R(A...), Policy>::~method() {
@@ -440,10 +877,171 @@ template<typename Key, typename R, class Policy, typename... A>
 typename method<Key, R(A...), Policy>::return_type inline method<
     Key, R(A...), Policy>::operator()(detail::remove_virtual<A>... args) const {
     using namespace detail;
+
+    if constexpr (
+        Policy::template has_facet<policy::closed_rtti> &&
+        has_closed_definitions<method>::value) {
+        auto pf = closed_table<>::value[closed_cell<types<A...>>(
+            argument_traits<Policy, A>::rarg(args)...)];
+        return pf(std::forward<remove_virtual<A>>(args)...);
+    }
+
+    // With 'concurrent_update', pin the image installed by the last 'update'
+    // while resolving the call. The definition is called after releasing it.
+    if constexpr (Policy::template has_facet<policy::concurrent_update>) {
+        function_pointer_type pf;
+
+        {
+            typename Policy::read_guard guard;
+            pf = resolve(argument_traits<Policy, A>::rarg(args)...);
+        }
+
+        return pf(std::forward<remove_virtual<A>>(args)...);
+    }
+
+    if constexpr (
+        Policy::template has_facet<policy::dispatch_functions> &&
+        has_dispatch_function<method>::value) {
+        static_assert(dispatch_function<method>::arity == arity);
+
+        const std::uintptr_t* vptrs[arity];
+        dispatch_vptrs<types<A...>>(
+            vptrs, argument_traits<Policy, A>::rarg(args)...);
+
+        return dispatch_function<method>::dispatch(
+            vptrs, [&](auto... definition) -> return_type {
+                if constexpr (sizeof...(definition) == 0) {
+                    auto pf =
+                        resolve(argument_traits<Policy, A>::rarg(args)...);
+                    return pf(std::forward<remove_virtual<A>>(args)...);
+                } else {
+                    using function =
+                        boost::mp11::mp_first<types<decltype(definition)...>>;
+                    using definition_thunk = thunk<
+                        Policy, signature_type, function::value,
+                        parameter_type_list_t<typename function::value_type>>;
+
+                    if constexpr (Policy::template has_facet<
+                                      policy::runtime_checks>) {
+                        check_dispatch_function(
+                            std::uintptr_t(resolve(
+                                argument_traits<Policy, A>::rarg(args)...)),
+                            std::uintptr_t(definition_thunk::fn));
+                    }
+
+                    return definition_thunk::fn(
+                        std::forward<remove_virtual<A>>(args)...);
+                }
+            });
+    }
+
+    if constexpr (has_static_guard<method>::value) {
+        static_assert(arity == 1, "static guards are for uni-methods");
+
+        using guard = static_guard<method>;
+        using guard_thunk = thunk<
+            Policy, signature_type, guard::function,
+            parameter_type_list_t<std::decay_t<decltype(guard::function)>>>;
+
+        auto vtbl = guard_vptr<types<A...>>(
+            argument_traits<Policy, A>::rarg(args)...);
+
+        if (vtbl == Policy::template static_vptr<typename guard::type>) {
+            if constexpr (Policy::template has_facet<policy::runtime_checks>) {
+                check_static_guard(vtbl, std::uintptr_t(guard_thunk::fn));
+            }
+
+            return guard_thunk::fn(std::forward<remove_virtual<A>>(args)...);
+        }
+    }
+
     auto pf = resolve(argument_traits<Policy, A>::rarg(args)...);
     return pf(std::forward<remove_virtual<A>>(args)...);
 }
 
+template<typename Key, typename R, class Policy, typename... A>
+template<class Range, typename... MoreArgs>
+void method<Key, R(A...), Policy>::for_each(
+    Range&& range, MoreArgs&&... more_args) const {
+    using namespace detail;
+    using namespace boost::mp11;
+
+    using virtual_arg_type = mp_first<types<A...>>;
+
+    static_assert(
+        arity == 1 && is_virtual<virtual_arg_type>::value,
+        "for_each requires a uni-method with the virtual parameter in first "
+        "position");
+
+    std::size_t slot;
+
+    if constexpr (has_static_offsets<method>::value) {
+        slot = static_offsets<method>::slots[0];
+        if constexpr (Policy::template has_facet<policy::runtime_checks>) {
+            check_static_offset<static_slot_error>(
+                static_offsets<method>::slots[0], this->slots_strides[0]);
+        }
+    } else {
+        slot = this->slots_strides[0];
+    }
+
+    auto iter = std::begin(range);
+    auto last = std::end(range);
+
+    while (iter != last) {
+        const std::uintptr_t* vtbls[batch_size];
+        auto block_first = iter;
+        std::size_t n = 0;
+
+        for (; n < batch_size && iter != last; ++n, ++iter) {
+            remove_virtual<virtual_arg_type> arg = *iter;
+            vtbls[n] =
+                vptr(argument_traits<Policy, virtual_arg_type>::rarg(arg));
+            prefetch(vtbls[n] + slot);
+
+            if constexpr (Policy::template has_facet<policy::call_counter>) {
+                Policy::count_call(*this, vtbls[n]);
+            }
+        }
+
+        iter = block_first;
+
+        for (std::size_t i = 0; i < n; ++i, ++iter) {
+            reinterpret_cast<function_pointer_type>(vtbls[i][slot])(
+                *iter, more_args...);
+        }
+    }
+}
+
+template<typename Key, typename R, class Policy, typename... A>
+template<class Range>
+void method<Key, R(A...), Policy>::apply_grouped(Range&& range) const {
+    using namespace detail;
+
+    using tuple_type =
+        std::remove_reference_t<decltype(*std::begin(range))>;
+
+    std::vector<std::pair<std::uintptr_t, tuple_type*>> calls;
+
+    for (auto& tuple : range) {
+        auto pf = std::apply(
+            [this](auto&... args) {
+                return resolve(argument_traits<Policy, A>::rarg(args)...);
+            },
+            tuple);
+        calls.emplace_back(reinterpret_cast<std::uintptr_t>(pf), &tuple);
+    }
+
+    std::stable_sort(
+        calls.begin(), calls.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (auto& call : calls) {
+        std::apply(
+            reinterpret_cast<function_pointer_type>(call.first), *call.second);
+    }
+}
+
 template<typename Key, typename R, class Policy, typename... A>
 template<typename... ArgType>
 inline typename method<Key, R(A...), Policy>::function_pointer_type
@@ -452,6 +1050,14 @@ method<Key, R(A...), Policy>::resolve(const ArgType&... args) const {
 
     std::uintptr_t pf;
 
+    if constexpr (skip_dead_dimensions) {
+        pf = installed_slots_strides()[2 * arity - 1];
+
+        if (pf) {
+            return reinterpret_cast<function_pointer_type>(pf);
+        }
+    }
+
     if constexpr (arity == 1) {
         pf = resolve_uni<types<A...>, ArgType...>(args...);
     } else {
@@ -461,6 +1067,98 @@ method<Key, R(A...), Policy>::resolve(const ArgType&... args) const {
     return reinterpret_cast<function_pointer_type>(pf);
 }
 
+template<typename Key, typename R, class Policy, typename... A>
+inline const std::size_t*
+method<Key, R(A...), Policy>::installed_slots_strides() const {
+    if constexpr (Policy::template has_facet<policy::concurrent_update>) {
+        return Policy::slots_strides(*this);
+    } else {
+        return slots_strides;
+    }
+}
+
+template<typename Key, typename R, class Policy, typename... A>
+template<typename>
+struct method<Key, R(A...), Policy>::closed_table {
+    using functions_type =
+        std::decay_t<decltype(closed_definitions<method>::functions)>;
+
+    template<std::size_t Index>
+    using function_type = std::tuple_element_t<Index, functions_type>;
+
+    template<std::size_t Index>
+    using definition_classes = detail::spec_polymorphic_types<
+        Policy, declared_argument_types,
+        detail::parameter_type_list_t<function_type<Index>>>;
+
+    using classes = boost::mp11::mp_push_back<
+        boost::mp11::mp_rename<typename Policy::closed_classes, detail::types>,
+        detail::closed_unknown_class>;
+
+    template<std::size_t... Index>
+    static auto select(std::index_sequence<Index...>)
+        -> detail::closed_selection<
+            classes, arity, definition_classes<Index>...>;
+
+    using selection = decltype(select(
+        std::make_index_sequence<std::tuple_size_v<functions_type>>()));
+
+    template<std::size_t Index>
+    static constexpr function_pointer_type entry() {
+        if constexpr (Index == detail::closed_no_definition) {
+            return not_implemented_handler;
+        } else if constexpr (Index == detail::closed_ambiguous) {
+            return ambiguous_handler;
+        } else {
+            constexpr auto function =
+                std::get<Index>(closed_definitions<method>::functions);
+
+            return detail::thunk<
+                Policy, signature_type, function,
+                detail::parameter_type_list_t<function_type<Index>>>::fn;
+        }
+    }
+
+    template<std::size_t... Cell>
+    static constexpr auto make_table(std::index_sequence<Cell...>) {
+        return std::array<function_pointer_type, sizeof...(Cell)>{
+            entry<selection::value[Cell]>()...};
+    }
+
+    static constexpr auto value =
+        make_table(std::make_index_sequence<selection::cells>());
+};
+
+template<typename Key, typename R, class Policy, typename... A>
+template<typename MethodArgList, typename ArgType, typename... MoreArgTypes>
+inline std::size_t method<Key, R(A...), Policy>::closed_cell(
+    const ArgType& arg, const MoreArgTypes&... more_args) const {
+    using namespace detail;
+    using namespace boost::mp11;
+
+    // the classes of the closed world, plus one for the other classes
+    constexpr std::size_t classes =
+        mp_size<typename Policy::closed_classes>::value + 1;
+
+    std::size_t cell = 0;
+
+    if constexpr (is_virtual<mp_first<MethodArgList>>::value) {
+        static_assert(
+            !is_virtual_ptr<ArgType>,
+            "virtual_ptr requires the tables built by 'update'");
+        cell = Policy::dynamic_type(arg);
+
+        if constexpr (sizeof...(MoreArgTypes) > 0) {
+            cell += classes *
+                closed_cell<mp_rest<MethodArgList>>(more_args...);
+        }
+    } else if constexpr (sizeof...(MoreArgTypes) > 0) {
+        cell = closed_cell<mp_rest<MethodArgList>>(more_args...);
+    }
+
+    return cell;
+}
+
 template<typename Key, typename R, class Policy, typename... A>
 template<typename ArgType>
 inline const std::uintptr_t*
@@ -474,6 +1172,83 @@ method<Key, R(A...), Policy>::vptr(const ArgType& arg) const {
     }
 }
 
+template<typename Key, typename R, class Policy, typename... A>
+template<typename MethodArgList, typename ArgType, typename... MoreArgTypes>
+inline const std::uintptr_t* method<Key, R(A...), Policy>::guard_vptr(
+    const ArgType& arg, const MoreArgTypes&... more_args) const {
+    using namespace detail;
+    using namespace boost::mp11;
+
+    if constexpr (is_virtual<mp_first<MethodArgList>>::value) {
+        if constexpr (is_virtual_ptr<ArgType>) {
+            return arg._vptr();
+        } else {
+            return vptr<ArgType>(arg);
+        }
+    } else {
+        return guard_vptr<mp_rest<MethodArgList>>(more_args...);
+    }
+}
+
+template<typename Key, typename R, class Policy, typename... A>
+inline void method<Key, R(A...), Policy>::check_static_guard(
+    const std::uintptr_t* vtbl, std::uintptr_t pf) const {
+    using namespace detail;
+
+    std::size_t slot;
+
+    if constexpr (has_static_offsets<method>::value) {
+        slot = static_offsets<method>::slots[0];
+    } else {
+        slot = this->slots_strides[0];
+    }
+
+    if (vtbl[slot] != pf) {
+        if (Policy::template has_facet<policy::error_handler>) {
+            static_guard_error error;
+            error.method = Policy::template static_type<method>();
+            error.type = Policy::template static_type<
+                typename static_guard<method>::type>();
+            Policy::error(error_type(std::move(error)));
+        }
+
+        abort();
+    }
+}
+
+template<typename Key, typename R, class Policy, typename... A>
+template<typename MethodArgList, typename ArgType, typename... MoreArgTypes>
+inline void method<Key, R(A...), Policy>::dispatch_vptrs(
+    const std::uintptr_t** vptrs, const ArgType& arg,
+    const MoreArgTypes&... more_args) const {
+    using namespace detail;
+    using namespace boost::mp11;
+
+    if constexpr (is_virtual<mp_first<MethodArgList>>::value) {
+        *vptrs++ = vptr<ArgType>(arg);
+    }
+
+    if constexpr (sizeof...(MoreArgTypes) > 0) {
+        dispatch_vptrs<mp_rest<MethodArgList>>(vptrs, more_args...);
+    }
+}
+
+template<typename Key, typename R, class Policy, typename... A>
+inline void method<Key, R(A...), Policy>::check_dispatch_function(
+    std::uintptr_t expected, std::uintptr_t pf) const {
+    using namespace detail;
+
+    if (pf != expected) {
+        if (Policy::template has_facet<policy::error_handler>) {
+            dispatch_function_error error;
+            error.method = Policy::template static_type<method>();
+            Policy::error(error_type(std::move(error)));
+        }
+
+        abort();
+    }
+}
+
 template<typename Key, typename R, class Policy, typename... A>
 template<class Error>
 inline void method<Key, R(A...), Policy>::check_static_offset(
@@ -510,6 +1285,10 @@ inline std::uintptr_t method<Key, R(A...), Policy>::resolve_uni(
             vtbl = vptr<ArgType>(arg);
         }
 
+        if constexpr (Policy::template has_facet<policy::call_counter>) {
+            Policy::count_call(*this, vtbl);
+        }
+
         if constexpr (has_static_offsets<method>::value) {
             if constexpr (Policy::template has_facet<policy::runtime_checks>) {
                 check_static_offset<static_slot_error>(
@@ -517,7 +1296,7 @@ inline std::uintptr_t method<Key, R(A...), Policy>::resolve_uni(
             }
             return vtbl[static_offsets<method>::slots[0]];
         } else {
-            return vtbl[this->slots_strides[0]];
+            return vtbl[installed_slots_strides()[0]];
         }
     } else {
         return resolve_uni<mp_rest<MethodArgList>>(more_args...);
@@ -541,6 +1320,10 @@ inline std::uintptr_t method<Key, R(A...), Policy>::resolve_multi_first(
             vtbl = vptr<ArgType>(arg);
         }
 
+        if constexpr (Policy::template has_facet<policy::call_counter>) {
+            Policy::count_call(*this, vtbl);
+        }
+
         std::size_t slot;
 
         if constexpr (has_static_offsets<method>::value) {
@@ -550,14 +1333,15 @@ inline std::uintptr_t method<Key, R(A...), Policy>::resolve_multi_first(
                     static_offsets<method>::slots[0], this->slots_strides[0]);
             }
         } else {
-            slot = this->slots_strides[0];
+            slot = installed_slots_strides()[0];
         }
 
         // The first virtual parameter is special.  Since its stride is
         // 1, there is no need to store it. Also, the method table
         // contains a pointer into the multi-dimensional dispatch table,
         // already resolved to the appropriate group.
-        auto dispatch = reinterpret_cast<const std::uintptr_t*>(vtbl[slot]);
+        auto dispatch =
+            reinterpret_cast<const dispatch_cell<Policy>*>(vtbl[slot]);
         return resolve_multi_next<1, mp_rest<MethodArgList>, MoreArgTypes...>(
             dispatch, more_args...);
     } else {
@@ -571,21 +1355,13 @@ template<
     std::size_t VirtualArg, typename MethodArgList, typename ArgType,
     typename... MoreArgTypes>
 inline std::uintptr_t method<Key, R(A...), Policy>::resolve_multi_next(
-    const std::uintptr_t* dispatch, const ArgType& arg,
+    const detail::dispatch_cell<Policy>* dispatch, const ArgType& arg,
     const MoreArgTypes&... more_args) const {
 
     using namespace detail;
     using namespace boost::mp11;
 
     if constexpr (is_virtual<mp_first<MethodArgList>>::value) {
-        const std::uintptr_t* vtbl;
-
-        if constexpr (is_virtual_ptr<ArgType>) {
-            vtbl = arg._vptr();
-        } else {
-            vtbl = vptr<ArgType>(arg);
-        }
-
         std::size_t slot, stride;
 
         if constexpr (has_static_offsets<method>::value) {
@@ -598,15 +1374,52 @@ inline std::uintptr_t method<Key, R(A...), Policy>::resolve_multi_next(
                     this->slots_strides[2 * VirtualArg], stride);
             }
         } else {
-            slot = this->slots_strides[VirtualArg];
-            stride = this->slots_strides[arity + VirtualArg - 1];
+            slot = installed_slots_strides()[VirtualArg];
+            stride = installed_slots_strides()[arity + VirtualArg - 1];
         }
 
-        dispatch = dispatch + vtbl[slot] * stride;
+        if (!skip_dead_dimensions ||
+            !(installed_slots_strides()[2 * arity] &
+              (std::size_t(1) << VirtualArg))) {
+            const std::uintptr_t* vtbl;
+
+            if constexpr (is_virtual_ptr<ArgType>) {
+                vtbl = arg._vptr();
+            } else {
+                vtbl = vptr<ArgType>(arg);
+            }
+
+            if constexpr (Policy::template has_facet<policy::call_counter>) {
+                Policy::count_call(*this, vtbl);
+            }
+
+            if constexpr (
+                VirtualArg + 1 == arity &&
+                Policy::template has_facet<policy::sparse_dispatch>) {
+                if (stride == sparse_stride) {
+                    // 'dispatch' points to a row: a pointer to the row's
+                    // cells, and the row's default function. A cell is a
+                    // (row, function) pair; it may belong to another row.
+                    auto row =
+                        reinterpret_cast<const std::uintptr_t*>(dispatch);
+                    auto cell =
+                        reinterpret_cast<const std::uintptr_t*>(row[0]) +
+                        2 * vtbl[slot];
+
+                    return cell[0] == std::uintptr_t(row) ? cell[1] : row[1];
+                }
+            }
+
+            dispatch = dispatch + vtbl[slot] * stride;
+        }
     }
 
     if constexpr (VirtualArg + 1 == arity) {
-        return *dispatch;
+        if constexpr (Policy::template has_facet<policy::narrow_dispatch>) {
+            return Policy::dispatch_data.data()[*dispatch];
+        } else {
+            return *dispatch;
+        }
     } else {
         return resolve_multi_next<
             VirtualArg + 1, mp_rest<MethodArgList>, MoreArgTypes...>(
@@ -11,6 +11,19 @@ template<class Policy, typename Data>
 void decode_dispatch_data(Data& init) {
     using namespace yorel::yomm2::detail;
 
+    static_assert(
+        !policy::has_facet<Policy, policy::narrow_dispatch>,
+        "encoded dispatch data does not support narrow dispatch tables");
+    static_assert(
+        !policy::has_facet<Policy, policy::sparse_dispatch>,
+        "encoded dispatch data does not support sparse dispatch tables");
+    static_assert(
+        !policy::has_facet<Policy, policy::dispatch_image>,
+        "encoded dispatch data does not support dispatch images");
+    static_assert(
+        !policy::has_facet<Policy, policy::dispatch_functions>,
+        "encoded dispatch data does not support class indices");
+
     constexpr auto pointer_size = sizeof(std::uintptr_t);
 
     trace_type<Policy> trace;
@@ -199,6 +212,8 @@ void decode_dispatch_data(Data& init) {
     if constexpr (Policy::template has_facet<policy::external_vptr>) {
         Policy::publish_vptrs(Policy::classes.begin(), Policy::classes.end());
     }
+
+    ++Policy::epoch;
 }
 
 } // namespace yomm2
@@ -4,6 +4,10 @@
 #include <yorel/yomm2/detail/static_list.hpp>
 
 #include <boost/assert.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+
+#include <array>
+#include <atomic>
 
 namespace yorel {
 namespace yomm2 {
@@ -181,6 +185,9 @@ struct yOMM2_API method_info : static_list<method_info>::static_link {
     void* not_implemented;
     type_id method_type;
     std::size_t* slots_strides_ptr;
+    // with 'concurrent_update': the index of the method in the images, or
+    // zero if not assigned yet
+    std::size_t image_index = 0;
 
     auto arity() const {
         return std::distance(vp_begin, vp_end);
@@ -225,6 +232,34 @@ struct next_ptr_t<R(T...)> {
 template<typename Method, typename Signature>
 inline typename next_ptr_t<Signature>::type next;
 
+// The type of the cells of multi-method dispatch tables: function pointers,
+// or indices with the 'narrow_dispatch' facet.
+template<class Policy, bool Narrow = policy::has_facet<
+                           Policy, policy::narrow_dispatch>>
+struct dispatch_cell_aux {
+    using type = std::uintptr_t;
+};
+
+template<class Policy>
+struct dispatch_cell_aux<Policy, true> {
+    using type = typename Policy::cell_type;
+};
+
+template<class Policy>
+using dispatch_cell = typename dispatch_cell_aux<Policy>::type;
+
+// Replaces the last stride of a multi-method whose dispatch table is sparse.
+constexpr std::size_t sparse_stride = std::size_t(1)
+    << (8 * sizeof(std::size_t) - 1);
+
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
 template<typename B, typename D, typename = void>
 struct requires_dynamic_cast_ref_aux : std::true_type {};
 
@@ -237,10 +272,78 @@ template<class B, class D>
 constexpr bool requires_dynamic_cast =
     requires_dynamic_cast_ref_aux<B, D>::value;
 
+#if defined(__GXX_ABI_VERSION)
+
+// On the Itanium C++ ABI, the address of the C++ v-table of a polymorphic
+// sub-object determines the layout of the complete object, thus the offset
+// from that sub-object to any of its bases. Cache the offsets found by
+// 'dynamic_cast_ref', keyed on that address. Slots are filled lock-free, and
+// never overwritten: a v-table that collides with another one always takes
+// the slow path. Offsets do not depend on the methods, so 'update' does not
+// invalidate the cache.
+template<class Policy, class D, class B>
+struct cast_offsets {
+    struct entry {
+        std::atomic<std::uintptr_t> vtable;
+        std::atomic<std::ptrdiff_t> offset;
+    };
+
+    static constexpr std::size_t bits = 6;
+    static constexpr auto mult = std::uintptr_t(0x9e3779b97f4a7c15);
+    // never a v-table address, marks a slot that is being filled
+    static constexpr std::uintptr_t busy = 1;
+
+    static entry cache[std::size_t(1) << bits];
+
+    static entry& find(std::uintptr_t vtable) {
+        return cache[(vtable * mult) >> (8 * sizeof(std::uintptr_t) - bits)];
+    }
+};
+
+template<class Policy, class D, class B>
+typename cast_offsets<Policy, D, B>::entry
+    cast_offsets<Policy, D, B>::cache[std::size_t(1) << bits];
+
+template<class Policy, class D, class B>
+D cached_dynamic_cast(B&& obj) {
+    using offsets = cast_offsets<Policy, D, std::decay_t<B>>;
+    auto address = reinterpret_cast<const char*>(&obj);
+    auto vtable = *reinterpret_cast<const std::uintptr_t*>(address);
+    auto& entry = offsets::find(vtable);
+
+    if (entry.vtable.load(std::memory_order_acquire) == vtable) {
+        return static_cast<D>(*reinterpret_cast<std::remove_reference_t<D>*>(
+            const_cast<char*>(address) +
+            entry.offset.load(std::memory_order_relaxed)));
+    }
+
+    D result = Policy::template dynamic_cast_ref<D>(obj);
+    std::uintptr_t empty = 0;
+
+    if (entry.vtable.compare_exchange_strong(
+            empty, offsets::busy, std::memory_order_acquire)) {
+        entry.offset.store(
+            reinterpret_cast<const char*>(&result) - address,
+            std::memory_order_relaxed);
+        entry.vtable.store(vtable, std::memory_order_release);
+    }
+
+    return static_cast<D>(result);
+}
+
+#endif
+
 template<class Policy, class D, class B>
 decltype(auto) optimal_cast(B&& obj) {
     if constexpr (requires_dynamic_cast<B, D>) {
-        return Policy::template dynamic_cast_ref<D>(obj);
+#if defined(__GXX_ABI_VERSION)
+        if constexpr (std::is_polymorphic_v<std::decay_t<B>>) {
+            return cached_dynamic_cast<Policy, D>(obj);
+        } else
+#endif
+        {
+            return Policy::template dynamic_cast_ref<D>(obj);
+        }
     } else {
         return static_cast<D>(obj);
     }
@@ -330,6 +433,154 @@ struct virtual_ptr_traits<std::shared_ptr<Class>, Policy> {
     }
 };
 
+template<class Class, class Policy>
+struct virtual_ptr_traits<std::unique_ptr<Class>, Policy> {
+    static bool constexpr is_smart_ptr = true;
+    using polymorphic_type = Class;
+
+    // unique_ptrs can only be moved, and transfer ownership
+    template<typename OtherPtrRef>
+    static decltype(auto) cast(std::unique_ptr<Class>&& ptr) {
+        using OtherPtr = typename std::remove_reference_t<OtherPtrRef>;
+        using OtherClass = typename OtherPtr::box_type::element_type;
+
+        return std::unique_ptr<OtherClass>(
+            &optimal_cast<Policy, OtherClass&>(*ptr.release()));
+    }
+};
+
+template<class Class, class Policy>
+struct virtual_ptr_traits<boost::intrusive_ptr<Class>, Policy> {
+    static bool constexpr is_smart_ptr = true;
+    using polymorphic_type = Class;
+
+    template<typename OtherPtrRef>
+    static decltype(auto) cast(const boost::intrusive_ptr<Class>& ptr) {
+        using OtherPtr = typename std::remove_reference_t<OtherPtrRef>;
+        using OtherClass = typename OtherPtr::box_type::element_type;
+
+        return boost::intrusive_ptr<OtherClass>(
+            &optimal_cast<Policy, OtherClass&>(*ptr));
+    }
+
+    // take over the reference, without touching the count
+    template<typename OtherPtrRef>
+    static decltype(auto) cast(boost::intrusive_ptr<Class>&& ptr) {
+        using OtherPtr = typename std::remove_reference_t<OtherPtrRef>;
+        using OtherClass = typename OtherPtr::box_type::element_type;
+
+        return boost::intrusive_ptr<OtherClass>(
+            &optimal_cast<Policy, OtherClass&>(*ptr.detach()), false);
+    }
+};
+
+// Storage for the object (or smart pointer to it) and the vptr held by a
+// virtual_ptr.
+template<class Policy, class Box, typename Vptr, bool Compact>
+class virtual_ptr_storage {
+    template<class, class, typename, bool>
+    friend class virtual_ptr_storage;
+
+    Box box;
+    Vptr vptr_;
+
+  public:
+    virtual_ptr_storage() = default;
+
+    template<class OtherBox>
+    virtual_ptr_storage(
+        const virtual_ptr_storage<Policy, OtherBox, Vptr, Compact>& other)
+        : box(other.box), vptr_(other.vptr_) {
+    }
+
+    template<class OtherBox>
+    virtual_ptr_storage(
+        virtual_ptr_storage<Policy, OtherBox, Vptr, Compact>&& other)
+        : box(std::move(other.box)), vptr_(other.vptr_) {
+    }
+
+    const Box& obj() const noexcept {
+        return box;
+    }
+
+    Box&& move_obj() noexcept {
+        return std::move(box);
+    }
+
+    template<class OtherBox>
+    void obj(OtherBox&& value) {
+        box = std::forward<OtherBox>(value);
+    }
+
+    Vptr vptr() const noexcept {
+        return vptr_;
+    }
+
+    void vptr(Vptr value) noexcept {
+        vptr_ = value;
+    }
+};
+
+// With the 'compact_vptr' facet, the object pointer and the vptr are packed
+// in a single word: the address of the object in the low bits, and the
+// signed offset of the vptr from 'Policy::dispatch_data', in words, in the
+// high bits. Only plain pointers on 64-bit platforms with 48-bit user space
+// addresses are supported.
+template<class Policy, class Class, typename Vptr>
+class virtual_ptr_storage<Policy, Class*, Vptr, true> {
+    template<class, class, typename, bool>
+    friend class virtual_ptr_storage;
+
+    static_assert(
+        sizeof(std::uintptr_t) == 8, "compact_vptr requires 64-bit pointers");
+    static_assert(
+        std::is_same_v<Vptr, const std::uintptr_t*>,
+        "compact_vptr cannot be combined with indirect_vptr");
+
+    static constexpr int offset_shift = 48;
+    static constexpr std::uintptr_t obj_mask =
+        (std::uintptr_t(1) << offset_shift) - 1;
+
+    std::uintptr_t word;
+
+  public:
+    virtual_ptr_storage() = default;
+
+    template<class OtherClass>
+    virtual_ptr_storage(
+        const virtual_ptr_storage<Policy, OtherClass*, Vptr, true>& other)
+        : word(other.word & ~obj_mask) {
+        obj(static_cast<Class*>(other.obj()));
+    }
+
+    Class* obj() const noexcept {
+        return reinterpret_cast<Class*>(word & obj_mask);
+    }
+
+    void obj(Class* value) noexcept {
+        auto address = reinterpret_cast<std::uintptr_t>(value);
+        BOOST_ASSERT((address & ~obj_mask) == 0);
+        word = (word & ~obj_mask) | address;
+    }
+
+    Vptr vptr() const noexcept {
+        return Policy::dispatch_data.data() +
+            (static_cast<std::intptr_t>(word) >> offset_shift);
+    }
+
+    void vptr(Vptr value) noexcept {
+        auto offset = (reinterpret_cast<std::intptr_t>(value) -
+                       reinterpret_cast<std::intptr_t>(
+                           Policy::dispatch_data.data())) /
+            std::intptr_t(sizeof(std::uintptr_t));
+        BOOST_ASSERT(
+            offset >= -(std::intptr_t(1) << (63 - offset_shift)) &&
+            offset < (std::intptr_t(1) << (63 - offset_shift)));
+        word = (word & obj_mask) |
+            (static_cast<std::uintptr_t>(offset) << offset_shift);
+    }
+};
+
 template<class Policy, class Class>
 struct virtual_traits<Policy, virtual_ptr<Class, Policy>> {
     using ptr_traits = virtual_ptr_traits<Class, Policy>;
@@ -344,6 +595,11 @@ struct virtual_traits<Policy, virtual_ptr<Class, Policy>> {
     static decltype(auto) cast(const virtual_ptr<Class, Policy>& ptr) {
         return ptr.template cast<Derived>();
     }
+
+    template<typename Derived>
+    static decltype(auto) cast(virtual_ptr<Class, Policy>&& ptr) {
+        return std::move(ptr).template cast<Derived>();
+    }
 };
 
 template<class Policy, class Class>
@@ -475,6 +731,27 @@ struct virtual_traits<Policy, std::shared_ptr<T>> {
     }
 };
 
+// Used by virtual_ptr to reach the object managed by a unique_ptr or an
+// intrusive_ptr.
+
+template<class Policy, typename T>
+struct virtual_traits<Policy, const std::unique_ptr<T>&> {
+    using polymorphic_type = std::remove_cv_t<T>;
+
+    static const T& rarg(const std::unique_ptr<T>& arg) {
+        return *arg;
+    }
+};
+
+template<class Policy, typename T>
+struct virtual_traits<Policy, const boost::intrusive_ptr<T>&> {
+    using polymorphic_type = std::remove_cv_t<T>;
+
+    static const T& rarg(const boost::intrusive_ptr<T>& arg) {
+        return *arg;
+    }
+};
+
 template<typename MethodArgList>
 using polymorphic_types = mp11::mp_transform<
     remove_virtual, mp11::mp_filter<detail::is_virtual, MethodArgList>>;
@@ -540,7 +817,7 @@ struct thunk<Policy, BASE_RETURN(BASE_PARAM...), SPEC, types<SPEC_PARAM...>> {
         using spec_type = mp11::mp_first<types<SPEC_PARAM...>>;
         return SPEC(
             argument_traits<Policy, BASE_PARAM>::template cast<SPEC_PARAM>(
-                remove_virtual<BASE_PARAM>(arg))...);
+                std::forward<remove_virtual<BASE_PARAM>>(arg))...);
     }
 };
 
@@ -622,6 +899,151 @@ struct has_static_offsets<
     Method, std::void_t<decltype(static_offsets<Method>::slots)>>
     : std::true_type {};
 
+// For a uni-method, the class that receives most of the calls according to a
+// call profile, and the function that implements the method for that class.
+// Calls for the class bypass the dispatch tables, and the function can be
+// inlined.
+template<class Method>
+struct static_guard;
+
+template<class Method, typename = void>
+struct has_static_guard : std::false_type {};
+
+template<class Method>
+struct has_static_guard<
+    Method, std::void_t<decltype(static_guard<Method>::function)>>
+    : std::true_type {};
+
+// For a closed hierarchy, a function that selects the definition of a method
+// by switching on the indices of the classes of the virtual arguments, stored
+// before their v-tables by 'dispatch_functions'. 'dispatch' calls 'call' with
+// the definition as a 'std::integral_constant', or without arguments if it
+// cannot select one.
+template<class Method>
+struct dispatch_function;
+
+template<class Method, typename = void>
+struct has_dispatch_function : std::false_type {};
+
+template<class Method>
+struct has_dispatch_function<
+    Method, std::void_t<decltype(dispatch_function<Method>::arity)>>
+    : std::true_type {};
+
+// -----------------------------------------------------------------------------
+// closed world dispatch
+
+// With 'closed_rtti', the definitions of a method are selected at compile
+// time, for each combination of the classes of the virtual arguments. A
+// combination is a cell; the class of the first virtual argument varies
+// fastest. Each class in 'Classes' is identified by its position, and
+// 'Definitions' contains the classes of the virtual parameters of each
+// definition.
+
+// Stands for the classes that are not in the closed world.
+struct closed_unknown_class {};
+
+constexpr std::size_t closed_no_definition = std::size_t(-1);
+constexpr std::size_t closed_ambiguous = std::size_t(-2);
+
+template<class Classes, class Params>
+struct closed_accepts;
+
+template<class... Classes, class... Params>
+struct closed_accepts<types<Classes...>, types<Params...>> {
+    template<class Param>
+    static constexpr std::array<bool, sizeof...(Classes)> row = {
+        std::is_base_of_v<Param, Classes>...};
+
+    // [virtual parameter][class]: the parameter accepts the class
+    static constexpr std::array<
+        std::array<bool, sizeof...(Classes)>, sizeof...(Params)>
+        value = {{row<Params>...}};
+};
+
+template<class Params, class OtherParams>
+struct closed_covers;
+
+template<class... Params, class... OtherParams>
+struct closed_covers<types<Params...>, types<OtherParams...>>
+    : std::bool_constant<(std::is_base_of_v<OtherParams, Params> && ...)> {};
+
+template<class Classes, std::size_t Arity, class... Definitions>
+struct closed_selection {
+    static constexpr std::size_t classes = boost::mp11::mp_size<Classes>::value;
+    static constexpr std::size_t definitions = sizeof...(Definitions);
+
+    static constexpr std::size_t cells = [] {
+        std::size_t cells = 1;
+
+        for (std::size_t dim = 0; dim < Arity; ++dim) {
+            cells *= classes;
+        }
+
+        return cells;
+    }();
+
+    template<class Definition>
+    static constexpr std::array<bool, definitions> covers_row = {
+        closed_covers<Definition, Definitions>::value...};
+
+    static constexpr std::array<
+        std::array<std::array<bool, classes>, Arity>, definitions>
+        accepts = {{closed_accepts<Classes, Definitions>::value...}};
+
+    // [definition][other definition]: the definition is at least as specific
+    // as the other definition
+    static constexpr std::array<std::array<bool, definitions>, definitions>
+        covers = {{covers_row<Definitions>...}};
+
+    // [cell]: the index of the selected definition, or 'closed_no_definition'
+    // or 'closed_ambiguous'
+    static constexpr std::array<std::size_t, cells> value = [] {
+        std::array<std::size_t, cells> value{};
+
+        for (std::size_t cell = 0; cell < cells; ++cell) {
+            std::array<bool, definitions> applicable{};
+
+            for (std::size_t def = 0; def < definitions; ++def) {
+                applicable[def] = true;
+
+                for (std::size_t dim = 0, index = cell; dim < Arity;
+                     ++dim, index /= classes) {
+                    if (!accepts[def][dim][index % classes]) {
+                        applicable[def] = false;
+                    }
+                }
+            }
+
+            std::size_t best = closed_no_definition;
+
+            for (std::size_t def = 0; def < definitions; ++def) {
+                if (!applicable[def]) {
+                    continue;
+                }
+
+                bool dominated = false;
+
+                for (std::size_t other = 0; other < definitions; ++other) {
+                    if (applicable[other] && covers[other][def] &&
+                        !covers[def][other]) {
+                        dominated = true;
+                    }
+                }
+
+                if (!dominated) {
+                    best = best == closed_no_definition ? def
+                                                        : closed_ambiguous;
+                }
+            }
+
+            value[cell] = best;
+        }
+
+        return value;
+    }();
+};
+
 // -----------------------------------------------------------------------------
 // report
 
@@ -632,6 +1054,12 @@ struct update_method_report {
     std::size_t concrete_not_implemented = 0;
     std::size_t ambiguous = 0;
     std::size_t concrete_ambiguous = 0;
+    std::size_t sparse_tables = 0;
+    std::size_t sparse_cells = 0;
+    // virtual parameters that do not take part in the resolution
+    std::size_t dead_dimensions = 0;
+    // methods that call the same function for all the arguments
+    std::size_t direct_methods = 0;
 };
 
 } // namespace detail
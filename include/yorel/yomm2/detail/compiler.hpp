@@ -13,9 +13,11 @@
 #include <algorithm>
 #include <cstdint>
 #include <deque>
+#include <limits>
 #include <map>
 #include <memory>
 #include <numeric>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -29,7 +31,13 @@ namespace yorel {
 namespace yomm2 {
 namespace detail {
 
-struct update_report : update_method_report {};
+struct update_report : update_method_report {
+    // not emitted, because identical to those of another method or class
+    std::size_t shared_cells = 0;
+    std::size_t shared_vtbl_entries = 0;
+    // 1 if nothing changed since the previous 'update', which was kept
+    std::size_t up_to_date = 0;
+};
 
 template<class Reports, class Facets, typename = void>
 struct aggregate_reports;
@@ -109,6 +117,7 @@ struct generic_compiler {
         std::size_t first_slot = 0;
         std::size_t mark = 0;   // temporary mark to detect cycles
         std::size_t weight = 0; // number of proper direct or indirect bases
+        std::size_t calls = 0;  // with 'call_profile'
         std::vector<vtbl_entry> vtbl;
         std::uintptr_t** static_vptr;
 
@@ -159,11 +168,21 @@ struct generic_compiler {
         // get the corresponding pointer from method_info
         definition not_implemented;
         definition ambiguous;
-        const std::uintptr_t* gv_dispatch_table{nullptr};
+        // with 'sparse_dispatch', for compressed tables: the displacement
+        // and the default definition of each row, and the other cells of
+        // all the rows, with the index of the row that owns them, plus one
+        // (zero for unused cells)
+        std::vector<std::pair<std::size_t, const definition*>> sparse_rows;
+        std::vector<std::pair<std::size_t, const definition*>> sparse_cells;
+        // the virtual parameters that do not take part in the resolution
+        bitvec dead_dimensions;
+        // points to 'std::uintptr_t's, or narrow cells
+        const void* gv_dispatch_table{nullptr};
         auto arity() const {
             return vp.size();
         }
         update_method_report report;
+        std::size_t calls = 0; // with 'call_profile'
     };
 
     std::deque<class_> classes;
@@ -239,11 +258,13 @@ struct compiler : generic_compiler {
     auto compile();
     auto update();
     void install_global_tables();
+    static std::vector<std::uintptr_t> catalog();
 
     void resolve_static_type_ids();
     void augment_classes();
     void calculate_covariant_classes(class_& cls);
     void augment_methods();
+    void apply_call_profile();
     void assign_slots();
     void assign_tree_slots(class_& cls, std::size_t base_slot);
     void assign_lattice_slots(class_& cls);
@@ -252,6 +273,8 @@ struct compiler : generic_compiler {
         method& m, std::size_t dim,
         std::vector<group_map>::const_iterator group, const bitvec& candidates,
         bool concrete);
+    void build_sparse_dispatch_table(method& m);
+    void find_dead_dimensions(method& m);
     void install_gv();
     void print(const update_method_report& report) const;
     static std::vector<const definition*>
@@ -268,6 +291,9 @@ struct compiler : generic_compiler {
         }
     }
 
+    // the catalog after the last 'update'
+    static std::vector<std::uintptr_t> installed_catalog;
+
     mutable trace_type<Policy> trace;
     static constexpr bool trace_enabled =
         Policy::template has_facet<policy::trace_output>;
@@ -283,6 +309,7 @@ void compiler<Policy>::install_global_tables() {
     }
 
     install_gv();
+    ++Policy::epoch;
 
     print(report);
     ++trace << "Finished\n";
@@ -293,6 +320,11 @@ auto compiler<Policy>::compile() {
     resolve_static_type_ids();
     augment_classes();
     augment_methods();
+
+    if constexpr (Policy::template has_facet<policy::call_profile>) {
+        apply_call_profile();
+    }
+
     assign_slots();
     build_dispatch_tables();
 
@@ -303,12 +335,72 @@ auto compiler<Policy>::compile() {
 
 template<class Policy>
 auto compiler<Policy>::update() {
+    // With 'call_profile', the same catalog can yield a different layout.
+    if constexpr (!Policy::template has_facet<policy::call_profile>) {
+        resolve_static_type_ids();
+
+        if (catalog() == installed_catalog) {
+            ++trace << "Nothing changed since the last update\n";
+            report.up_to_date = 1;
+
+            return *this;
+        }
+    }
+
     compile();
     install_global_tables();
+    installed_catalog = catalog();
 
     return *this;
 }
 
+// The classes, methods and definitions registered in the policy, and the
+// values that 'update' installed in them. Loading or unloading a library
+// changes the catalog, even if the library is loaded again at the same
+// address, because the variables it contains are reset.
+template<class Policy>
+std::vector<std::uintptr_t> compiler<Policy>::catalog() {
+    std::vector<std::uintptr_t> catalog;
+    catalog.push_back(std::uintptr_t(Policy::dispatch_data.data()));
+    catalog.push_back(Policy::dispatch_data.size());
+
+    for (auto& cls : Policy::classes) {
+        catalog.push_back(cls.type);
+        catalog.push_back(cls.last_base - cls.first_base);
+        catalog.insert(catalog.end(), cls.first_base, cls.last_base);
+        catalog.push_back(std::uintptr_t(cls.static_vptr));
+        catalog.push_back(std::uintptr_t(*cls.static_vptr));
+    }
+
+    catalog.push_back(-1);
+
+    for (auto& method : Policy::methods) {
+        auto arity = method.arity();
+        catalog.push_back(method.method_type);
+        catalog.push_back(arity);
+        catalog.insert(catalog.end(), method.vp_begin, method.vp_end);
+        catalog.push_back(std::uintptr_t(method.slots_strides_ptr));
+        catalog.insert(
+            catalog.end(), method.slots_strides_ptr,
+            method.slots_strides_ptr + 2 * arity + 1);
+
+        for (auto& spec : method.specs) {
+            catalog.push_back(spec.type);
+            catalog.push_back(std::uintptr_t(spec.pf));
+            catalog.insert(catalog.end(), spec.vp_begin, spec.vp_end);
+            catalog.push_back(std::uintptr_t(spec.next));
+            catalog.push_back(spec.next ? std::uintptr_t(*spec.next) : 0);
+        }
+
+        catalog.push_back(-1);
+    }
+
+    return catalog;
+}
+
+template<class Policy>
+std::vector<std::uintptr_t> compiler<Policy>::installed_catalog;
+
 template<class Policy>
 compiler<Policy>::compiler() {
 }
@@ -320,10 +412,16 @@ void compiler<Policy>::resolve_static_type_ids() {
         *p = pf();
     };
 
+    // Lists of type ids may be shared, and 'update' may be called more than
+    // once: the extra element at the end of each list is zero until its ids
+    // are resolved.
     if constexpr (std::is_base_of_v<policy::deferred_static_rtti, Policy>) {
         if (!Policy::classes.empty())
             for (auto& ci : Policy::classes) {
-                resolve(&ci.type);
+                if (!ci.is_resolved) {
+                    resolve(&ci.type);
+                    ci.is_resolved = true;
+                }
 
                 if (*ci.last_base == 0) {
                     for (auto& ti : range{ci.first_base, ci.last_base}) {
@@ -336,25 +434,25 @@ void compiler<Policy>::resolve_static_type_ids() {
 
         if (!Policy::methods.empty())
             for (auto& method : Policy::methods) {
-                for (auto& ti : range{method.vp_begin, method.vp_end}) {
-                    if (*method.vp_end == 0) {
+                if (*method.vp_end == 0) {
+                    for (auto& ti : range{method.vp_begin, method.vp_end}) {
                         resolve(&ti);
-                        *method.vp_end = 1;
                     }
 
-                    if (!method.specs.empty())
-                        for (auto& definition : method.specs) {
-                            if (*definition.vp_end == 0) {
-                                for (auto& ti : range{
-                                         definition.vp_begin,
-                                         definition.vp_end}) {
-                                    resolve(&ti);
-                                }
+                    *method.vp_end = 1;
+                }
 
-                                *definition.vp_end = 1;
+                if (!method.specs.empty())
+                    for (auto& definition : method.specs) {
+                        if (*definition.vp_end == 0) {
+                            for (auto& ti : range{
+                                     definition.vp_begin, definition.vp_end}) {
+                                resolve(&ti);
                             }
+
+                            *definition.vp_end = 1;
                         }
-                }
+                    }
             }
     }
 }
@@ -625,6 +723,53 @@ void compiler<Policy>::augment_methods() {
     }
 }
 
+template<class Policy>
+void compiler<Policy>::apply_call_profile() {
+    ++trace << "Applying call profile...\n";
+    indent _(trace);
+
+    std::unordered_map<std::string, method*> method_names;
+    std::unordered_map<std::string, class_*> class_names;
+
+    for (auto& m : methods) {
+        std::ostringstream name;
+        Policy::type_name(m.info->method_type, name);
+        method_names.emplace(name.str(), &m);
+    }
+
+    for (auto& cls : classes) {
+        for (auto ti : cls.type_ids) {
+            std::ostringstream name;
+            Policy::type_name(ti, name);
+            class_names.emplace(name.str(), &cls);
+        }
+    }
+
+    for (auto& [key, calls] : Policy::profile) {
+        auto method_iter = method_names.find(key.first);
+        auto class_iter = class_names.find(key.second);
+
+        if (method_iter == method_names.end() ||
+            class_iter == class_names.end()) {
+            ++trace << "ignoring " << key.first << " " << key.second << "\n";
+            ++report.stale_profile_entries;
+            continue;
+        }
+
+        method_iter->second->calls += calls;
+        class_iter->second->calls += calls;
+        report.profiled_calls += calls;
+    }
+
+    // Give the first slots to the methods called most often, so their
+    // entries are at the beginning of the v-tables.
+    for (auto& cls : classes) {
+        std::stable_sort(
+            cls.used_by_vp.begin(), cls.used_by_vp.end(),
+            [](auto& a, auto& b) { return a.method->calls > b.method->calls; });
+    }
+}
+
 template<class Policy>
 void compiler<Policy>::assign_slots() {
     ++trace << "Allocating slots...\n";
@@ -661,9 +806,16 @@ void compiler<Policy>::assign_slots() {
                 continue;
             }
 
-            auto first_slot = cls.used_slots.find_first();
-            cls.first_slot =
-                first_slot == boost::dynamic_bitset<>::npos ? 0 : first_slot;
+            // With 'dispatch_functions', the class index is stored just
+            // before slot 0.
+            if constexpr (!Policy::template has_facet<
+                              policy::dispatch_functions>) {
+                auto first_slot = cls.used_slots.find_first();
+                cls.first_slot = first_slot == boost::dynamic_bitset<>::npos
+                    ? 0
+                    : first_slot;
+            }
+
             cls.vtbl.resize(cls.used_slots.size() - cls.first_slot);
             ++trace << cls << " vtbl: " << cls.first_slot << "-"
                     << cls.used_slots.size() << " slots " << cls.used_slots
@@ -887,8 +1039,16 @@ void compiler<Policy>::build_dispatch_tables() {
                 }
 
                 trace << "\n";
+
+                if constexpr (Policy::template has_facet<
+                                  policy::sparse_dispatch>) {
+                    if (m.report.cells > Policy::max_dense_cells) {
+                        build_sparse_dispatch_table(m);
+                    }
+                }
             }
 
+            find_dead_dimensions(m);
             print(m.report);
             accumulate(m.report, report);
             ++trace << "assigning next\n";
@@ -1021,6 +1181,154 @@ void compiler<Policy>::build_dispatch_table(
     }
 }
 
+// A dimension is dead if the cells that differ only by the group of the
+// argument in that dimension use the same definition. If all the dimensions
+// are dead, the method always calls the same function.
+template<class Policy>
+void compiler<Policy>::find_dead_dimensions(method& m) {
+    auto dims = m.arity();
+    auto cells = m.dispatch_table.size();
+    m.dead_dimensions.clear();
+    m.dead_dimensions.resize(dims);
+
+    if (cells == 0) {
+        return;
+    }
+
+    for (std::size_t dim = 0; dim < dims; ++dim) {
+        if (dim + 1 == dims && !m.sparse_rows.empty()) {
+            // the cells of a sparse row are found via the last argument
+            continue;
+        }
+
+        auto stride = dim == 0 ? 1 : m.strides[dim - 1];
+        auto groups = (dim + 1 == dims ? cells : m.strides[dim]) / stride;
+        bool dead = true;
+
+        for (std::size_t cell = 0; dead && cell < cells; ++cell) {
+            auto group = cell / stride % groups;
+            dead = m.dispatch_table[cell] ==
+                m.dispatch_table[cell - group * stride];
+        }
+
+        if (dead) {
+            ++trace << "dimension " << dim << " is dead\n";
+            m.dead_dimensions[dim] = true;
+            ++m.report.dead_dimensions;
+        }
+    }
+
+    if (m.dead_dimensions.all()) {
+        ++trace << "direct call to " << spec_name(m, m.dispatch_table[0])
+                << "\n";
+        ++m.report.direct_methods;
+    }
+}
+
+template<class Policy>
+void compiler<Policy>::build_sparse_dispatch_table(method& m) {
+    // The last dimension varies the slowest; a row is a combination of
+    // groups in all the other dimensions, and its cells are 'rows' apart in
+    // the dense table.
+    auto rows = m.strides.back();
+    auto columns = m.dispatch_table.size() / rows;
+
+    std::vector<std::pair<std::size_t, const definition*>> sparse_rows(rows);
+    std::vector<std::vector<std::size_t>> exceptions(rows);
+
+    for (std::size_t row = 0; row < rows; ++row) {
+        std::unordered_map<const definition*, std::size_t> occurrences;
+        const definition* most_common = nullptr;
+        std::size_t max_occurrences = 0;
+
+        for (std::size_t column = 0; column < columns; ++column) {
+            auto spec = m.dispatch_table[row + column * rows];
+
+            if (++occurrences[spec] > max_occurrences) {
+                max_occurrences = occurrences[spec];
+                most_common = spec;
+            }
+        }
+
+        sparse_rows[row].second = most_common;
+
+        for (std::size_t column = 0; column < columns; ++column) {
+            if (m.dispatch_table[row + column * rows] != most_common) {
+                exceptions[row].push_back(column);
+            }
+        }
+    }
+
+    // First fit, placing the fullest rows first.
+    std::vector<std::size_t> order(rows);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(
+        order.begin(), order.end(), [&exceptions](auto a, auto b) {
+            return exceptions[a].size() > exceptions[b].size();
+        });
+
+    std::vector<std::pair<std::size_t, const definition*>> sparse_cells;
+    std::size_t first_free = 0;
+
+    for (auto row : order) {
+        auto& row_exceptions = exceptions[row];
+
+        if (row_exceptions.empty()) {
+            continue;
+        }
+
+        auto displacement = first_free > row_exceptions.front()
+            ? first_free - row_exceptions.front()
+            : 0;
+
+        while (std::any_of(
+            row_exceptions.begin(), row_exceptions.end(),
+            [&sparse_cells, displacement](auto column) {
+                return displacement + column < sparse_cells.size() &&
+                    sparse_cells[displacement + column].first;
+            })) {
+            ++displacement;
+        }
+
+        if (displacement + columns > sparse_cells.size()) {
+            sparse_cells.resize(displacement + columns);
+        }
+
+        for (auto column : row_exceptions) {
+            sparse_cells[displacement + column] = {
+                row + 1, m.dispatch_table[row + column * rows]};
+        }
+
+        while (first_free < sparse_cells.size() &&
+               sparse_cells[first_free].first) {
+            ++first_free;
+        }
+
+        sparse_rows[row].first = displacement;
+    }
+
+    // Rows without exceptions look up cells at displacement zero.
+    if (sparse_cells.size() < columns) {
+        sparse_cells.resize(columns);
+    }
+
+    // Rows and cells are two words each.
+    auto sparse_size = 2 * (rows + sparse_cells.size());
+
+    ++trace << "sparse table: " << rows << " rows, " << sparse_cells.size()
+            << " cells, " << sparse_size << " words instead of "
+            << m.dispatch_table.size() << "\n";
+
+    if (sparse_size >= m.dispatch_table.size()) {
+        return;
+    }
+
+    m.sparse_rows = std::move(sparse_rows);
+    m.sparse_cells = std::move(sparse_cells);
+    m.report.sparse_tables = 1;
+    m.report.sparse_cells = m.sparse_cells.size();
+}
+
 inline void generic_compiler::accumulate(
     const update_method_report& partial, update_report& total) {
     total.cells += partial.cells;
@@ -1029,29 +1337,281 @@ inline void generic_compiler::accumulate(
     total.concrete_not_implemented += partial.concrete_not_implemented != 0;
     total.ambiguous += partial.ambiguous != 0;
     total.concrete_ambiguous += partial.concrete_ambiguous != 0;
+    total.sparse_tables += partial.sparse_tables;
+    total.sparse_cells += partial.sparse_cells;
+    total.dead_dimensions += partial.dead_dimensions;
+    total.direct_methods += partial.direct_methods;
 }
 
 template<class Policy>
 void compiler<Policy>::install_gv() {
     using namespace policy;
 
+    constexpr bool narrow = has_facet<Policy, narrow_dispatch>;
+
+    constexpr bool image = has_facet<Policy, dispatch_image>;
+    constexpr bool concurrent = has_facet<Policy, concurrent_update>;
+    constexpr bool aligned = has_facet<Policy, cache_aligned_dispatch>;
+    constexpr std::size_t index_words =
+        has_facet<Policy, dispatch_functions> ? 1 : 0;
+
+    static_assert(
+        !(narrow && has_facet<Policy, sparse_dispatch>),
+        "narrow and sparse dispatch tables cannot be combined");
+    static_assert(
+        !(narrow && image),
+        "narrow dispatch tables cannot be stored in a dispatch image");
+    static_assert(
+        !(narrow && aligned),
+        "narrow dispatch tables cannot be aligned on cache lines");
+    static_assert(
+        !(concurrent && (narrow || aligned)),
+        "concurrent update does not support narrow or aligned tables");
+    static_assert(
+        !(concurrent && has_facet<Policy, indirect_vptr>),
+        "concurrent update does not support indirect vptrs");
+
+    // With 'call_profile', the tables used most often are written first.
+    std::vector<method*> method_order;
+    std::vector<class_*> class_order;
+
+    for (auto& m : methods) {
+        method_order.push_back(&m);
+    }
+
+    for (auto& cls : classes) {
+        class_order.push_back(&cls);
+    }
+
+    if constexpr (has_facet<Policy, call_profile>) {
+        auto hotter = [](auto a, auto b) { return a->calls > b->calls; };
+        std::stable_sort(method_order.begin(), method_order.end(), hotter);
+        std::stable_sort(class_order.begin(), class_order.end(), hotter);
+    }
+
+    // Methods that use the same functions in the same cells share their
+    // dispatch table, even if their groups differ, because the v-tables
+    // contain the group indices.
+    std::map<std::vector<std::uintptr_t>, method*> tables;
+    std::vector<method*> table_owner(methods.size());
+    std::size_t dispatch_table_size = 0;
+
+    for (auto pm : method_order) {
+        auto& m = *pm;
+
+        if (m.arity() == 1) {
+            continue;
+        }
+
+        auto size = m.sparse_rows.empty()
+            ? m.dispatch_table.size()
+            : 2 * (m.sparse_rows.size() + m.sparse_cells.size());
+        std::vector<std::uintptr_t> cells{m.sparse_rows.size()};
+
+        if (m.sparse_rows.empty()) {
+            for (auto spec : m.dispatch_table) {
+                cells.push_back(spec->pf);
+            }
+        } else {
+            for (auto [displacement, spec] : m.sparse_rows) {
+                cells.push_back(displacement);
+                cells.push_back(spec->pf);
+            }
+
+            for (auto [row, spec] : m.sparse_cells) {
+                cells.push_back(row);
+                cells.push_back(row ? spec->pf : 0);
+            }
+        }
+
+        auto [iter, inserted] = tables.emplace(std::move(cells), &m);
+        table_owner[&m - &methods[0]] = iter->second;
+
+        if (inserted) {
+            dispatch_table_size += size;
+        } else {
+            ++trace << type_name(m.info->method_type)
+                    << " shares the dispatch table of "
+                    << type_name(iter->second->info->method_type) << "\n";
+            report.shared_cells += size;
+        }
+    }
+
     auto dispatch_data_size = std::accumulate(
-        methods.begin(), methods.end(), std::size_t(0),
-        [](auto sum, auto& m) { return sum + m.dispatch_table.size(); });
-    dispatch_data_size = std::accumulate(
-        classes.begin(), classes.end(), dispatch_data_size,
+        classes.begin(), classes.end(), std::size_t(0),
         [](auto sum, auto& cls) { return sum + cls.vtbl.size(); });
 
-    Policy::dispatch_data.resize(dispatch_data_size);
-    auto gv_first = Policy::dispatch_data.data();
-    auto gv_last = gv_first + Policy::dispatch_data.size();
+    // With 'narrow_dispatch', the cells of the dispatch tables are indices in
+    // an array of the functions used by all the multi-methods, placed at the
+    // beginning of 'dispatch_data'.
+    std::unordered_map<std::uintptr_t, std::size_t> definition_index;
+
+    if constexpr (narrow) {
+        for (auto& m : methods) {
+            if (m.info->arity() > 1) {
+                for (auto spec : m.dispatch_table) {
+                    definition_index.emplace(
+                        spec->pf, definition_index.size());
+                }
+            }
+        }
+
+        if (definition_index.size() >
+            std::size_t((std::numeric_limits<dispatch_cell<Policy>>::max)()) +
+                1) {
+            ++trace << "Too many definitions for the cell type\n";
+            abort();
+        }
+
+        dispatch_data_size += definition_index.size();
+        Policy::cell_data.resize(dispatch_table_size);
+
+        report.dispatch_bytes_saved =
+            std::ptrdiff_t(
+                dispatch_table_size *
+                (sizeof(std::uintptr_t) - sizeof(dispatch_cell<Policy>))) -
+            std::ptrdiff_t(definition_index.size() * sizeof(std::uintptr_t));
+        ++trace << "Narrow dispatch tables save " << report.dispatch_bytes_saved
+                << " bytes\n";
+    } else {
+        dispatch_data_size += dispatch_table_size;
+    }
+
+    // With 'dispatch_functions', room for the index of each class.
+    dispatch_data_size += index_words * classes.size();
+
+    // With 'cache_aligned_dispatch', room for the padding of each v-table and
+    // dispatch table, and for aligning the beginning of 'dispatch_data'.
+    [[maybe_unused]] std::size_t line_words = 1;
+
+    if constexpr (aligned) {
+        line_words = Policy::line_size / sizeof(std::uintptr_t);
+        dispatch_data_size +=
+            (line_words - 1) * (classes.size() + methods.size() + 1);
+    }
+
+    std::uintptr_t *gv_first, *gv_last;
+
+    if constexpr (image) {
+        auto vptrs_size =
+            Policy::initialize_image(classes.begin(), classes.end());
+
+        if (vptrs_size + dispatch_data_size > Policy::image_size) {
+            ++trace << "Dispatch image is too small, "
+                    << vptrs_size + dispatch_data_size << " words needed\n";
+            abort();
+        }
+
+        gv_first = Policy::image + vptrs_size;
+        gv_last = gv_first + dispatch_data_size;
+    } else if constexpr (concurrent) {
+        gv_first = Policy::initialize_image(
+            classes.begin(), classes.end(), dispatch_data_size);
+        gv_last = gv_first + dispatch_data_size;
+    } else {
+        Policy::dispatch_data.resize(dispatch_data_size);
+        gv_first = Policy::dispatch_data.data();
+        gv_last = gv_first + dispatch_data_size;
+
+        if constexpr (aligned) {
+            auto misalignment = std::uintptr_t(gv_first) % Policy::line_size;
+
+            if (misalignment) {
+                gv_first += (Policy::line_size - misalignment) /
+                    sizeof(std::uintptr_t);
+            }
+        }
+    }
+
     auto gv_iter = gv_first;
+    dispatch_cell<Policy>* cell_iter;
+
+    // Skip to the next cache line, if a block that fits in one would
+    // otherwise straddle two.
+    auto align = [&](std::uintptr_t*& iter, std::size_t size) {
+        if constexpr (aligned) {
+            auto used = std::uintptr_t(iter) % Policy::line_size /
+                sizeof(std::uintptr_t);
+
+            if (size <= line_words && used + size > line_words) {
+                auto padding = line_words - used;
+                BOOST_ASSERT(iter + padding <= gv_last);
+                iter = std::fill_n(iter, padding, 0);
+                report.padding_words += padding;
+            }
+        }
+    };
 
-    ++trace << "Initializing multi-method dispatch tables at " << gv_iter
+    auto write_table = [&](method& m) {
+        if constexpr (!narrow) {
+            align(
+                cell_iter,
+                m.sparse_rows.empty()
+                    ? m.dispatch_table.size()
+                    : 2 * (m.sparse_rows.size() + m.sparse_cells.size()));
+        }
+
+        m.gv_dispatch_table = cell_iter;
+
+        if constexpr (narrow) {
+            cell_iter = std::transform(
+                m.dispatch_table.begin(), m.dispatch_table.end(), cell_iter,
+                [&definition_index](auto spec) {
+                    return dispatch_cell<Policy>(definition_index[spec->pf]);
+                });
+        } else if (!m.sparse_rows.empty()) {
+            auto rows = cell_iter;
+            auto cells = rows + 2 * m.sparse_rows.size();
+            BOOST_ASSERT(cells + 2 * m.sparse_cells.size() <= gv_last);
+
+            for (auto [displacement, spec] : m.sparse_rows) {
+                *cell_iter++ = std::uintptr_t(cells + 2 * displacement);
+                *cell_iter++ = spec->pf;
+            }
+
+            for (auto [row, spec] : m.sparse_cells) {
+                if (row) {
+                    *cell_iter++ = std::uintptr_t(rows + 2 * (row - 1));
+                    *cell_iter++ = spec->pf;
+                } else {
+                    *cell_iter++ = 0;
+                    *cell_iter++ = 0;
+                }
+            }
+        } else {
+            BOOST_ASSERT(cell_iter + m.dispatch_table.size() <= gv_last);
+            cell_iter = std::transform(
+                m.dispatch_table.begin(), m.dispatch_table.end(), cell_iter,
+                [](auto spec) { return spec->pf; });
+        }
+    };
+
+    if constexpr (narrow) {
+        for (auto [pf, index] : definition_index) {
+            gv_first[index] = pf;
+        }
+
+        gv_iter += definition_index.size();
+        cell_iter = Policy::cell_data.data();
+    } else {
+        cell_iter = gv_iter;
+    }
+
+    ++trace << "Initializing multi-method dispatch tables at " << cell_iter
             << "\n";
 
-    for (auto& m : methods) {
-        if (m.info->arity() == 1) {
+    for (auto pm : method_order) {
+        auto& m = *pm;
+
+        // After the slots and the strides: the function to call if it does
+        // not depend on the arguments, or zero, and the dead dimensions.
+        auto arity = m.arity();
+        m.info->slots_strides_ptr[2 * arity - 1] = m.dead_dimensions.all()
+            ? m.dispatch_table[0]->pf
+            : 0;
+        m.info->slots_strides_ptr[2 * arity] = m.dead_dimensions.to_ulong();
+
+        if (arity == 1) {
             // Uni-methods just need an index in the method table.
             m.info->slots_strides_ptr[0] = m.slots[0];
             continue;
@@ -1061,10 +1621,20 @@ void compiler<Policy>::install_gv() {
 
         auto strides_iter = std::copy(
             m.slots.begin(), m.slots.end(), m.info->slots_strides_ptr);
-        std::copy(m.strides.begin(), m.strides.end(), strides_iter);
+
+        if (m.sparse_rows.empty()) {
+            std::copy(m.strides.begin(), m.strides.end(), strides_iter);
+        } else {
+            // Rows are two words wide; the last dimension indexes the cells
+            // of a row.
+            strides_iter = std::transform(
+                m.strides.begin(), m.strides.end() - 1, strides_iter,
+                [](auto stride) { return 2 * stride; });
+            *strides_iter = sparse_stride;
+        }
 
         if constexpr (trace_enabled) {
-            ++trace << rflush(4, Policy::dispatch_data.size()) << " "
+            ++trace << rflush(4, dispatch_data_size) << " "
                     << " method #" << m.dispatch_table[0]->method_index << " "
                     << type_name(m.info->method_type) << "\n";
             indent _(trace);
@@ -1075,22 +1645,56 @@ void compiler<Policy>::install_gv() {
             }
         }
 
-        m.gv_dispatch_table = gv_iter;
-        BOOST_ASSERT(gv_iter + m.dispatch_table.size() <= gv_last);
-        gv_iter = std::transform(
-            m.dispatch_table.begin(), m.dispatch_table.end(), gv_iter,
-            [](auto spec) { return spec->pf; });
+        // With 'cache_aligned_dispatch', tables are written just before the
+        // first v-table that points into them.
+        if (table_owner[&m - &methods[0]] == &m && !aligned) {
+            write_table(m);
+        }
+    }
+
+    if constexpr (!narrow) {
+        gv_iter = cell_iter;
     }
 
     ++trace << "Initializing v-tables at " << gv_iter << "\n";
 
-    for (auto& cls : classes) {
+    // Classes that have the same slots, containing the same values, share
+    // their v-table. This typically happens for classes that do not
+    // specialize any method.
+    std::map<std::vector<std::uintptr_t>, std::uintptr_t*> vtbls;
+
+    for (auto pcls : class_order) {
+        auto& cls = *pcls;
+
         if (cls.first_slot == -1) {
             // corner case: no methods for this class
             *cls.static_vptr = gv_iter;
             continue;
         }
 
+        if constexpr (aligned) {
+            for (auto& entry : cls.vtbl) {
+                auto owner = table_owner[entry.method_index];
+
+                if (entry.vp_index == 0 && owner &&
+                    !owner->gv_dispatch_table) {
+                    cell_iter = gv_iter;
+                    write_table(*owner);
+                    gv_iter = cell_iter;
+                }
+            }
+        }
+
+        auto vtbl_start = gv_iter;
+        align(gv_iter, index_words + cls.vtbl.size());
+
+        if constexpr (index_words) {
+            // set below, unless the v-table is shared
+            BOOST_ASSERT(gv_iter + 1 <= gv_last);
+            *gv_iter++ = 0;
+        }
+
+        auto vtbl = gv_iter;
         *cls.static_vptr = gv_iter - cls.first_slot;
 
         ++trace << rflush(4, gv_iter - gv_first) << " " << gv_iter
@@ -1118,8 +1722,12 @@ void compiler<Policy>::install_gv() {
                 BOOST_ASSERT(gv_iter + 1 <= gv_last);
 
                 if (entry.vp_index == 0) {
+                    auto cell_size = method.sparse_rows.empty() ? 1 : 2;
                     *gv_iter++ = std::uintptr_t(
-                        method.gv_dispatch_table + entry.group_index);
+                        static_cast<const dispatch_cell<Policy>*>(
+                            table_owner[entry.method_index]
+                                ->gv_dispatch_table) +
+                        cell_size * entry.group_index);
                 } else {
                     *gv_iter++ = entry.group_index;
                 }
@@ -1127,11 +1735,55 @@ void compiler<Policy>::install_gv() {
 
             trace << "\n";
         }
+
+        std::vector<std::uintptr_t> entries{cls.first_slot};
+        entries.insert(entries.end(), vtbl, gv_iter);
+        auto [iter, inserted] = vtbls.emplace(std::move(entries), vtbl);
+
+        if constexpr (index_words) {
+            if (inserted) {
+                vtbl[-1] = report.class_indices++;
+                ++trace << "class index " << vtbl[-1] << "\n";
+            }
+        }
+
+        if (!inserted) {
+            ++trace << "same as " << iter->second << "\n";
+            *cls.static_vptr = iter->second - cls.first_slot;
+            report.shared_vtbl_entries += cls.vtbl.size();
+
+            if constexpr (aligned) {
+                report.padding_words -= vtbl - index_words - vtbl_start;
+            }
+
+            gv_iter = vtbl_start;
+        }
     }
 
-    ++trace << rflush(4, Policy::dispatch_data.size()) << " " << gv_iter
+    ++trace << rflush(4, dispatch_data_size) << " " << gv_iter
             << " end\n";
 
+    if (report.shared_cells || report.shared_vtbl_entries) {
+        ++trace << "Shared " << report.shared_cells << " dispatch table cells, "
+                << report.shared_vtbl_entries << " v-table entries\n";
+    }
+
+    if constexpr (aligned) {
+        ++trace << "Cache line padding: " << report.padding_words
+                << " words\n";
+    }
+
+    if constexpr (concurrent) {
+        for (auto& m : methods) {
+            std::copy_n(
+                m.info->slots_strides_ptr, 2 * m.arity() + 1,
+                Policy::next_slots_strides(*m.info));
+        }
+    } else if constexpr (!image) {
+        // Does not reallocate.
+        Policy::dispatch_data.resize(gv_iter - Policy::dispatch_data.data());
+    }
+
     if constexpr (has_facet<Policy, external_vptr>) {
         Policy::publish_vptrs(classes.begin(), classes.end());
     }
@@ -1225,6 +1877,16 @@ void compiler<Policy>::print(const update_method_report& report) const {
 
     trace << report.concrete_not_implemented << ", ";
     trace << report.concrete_ambiguous << "\n";
+
+    if (report.sparse_tables) {
+        ++trace << report.sparse_tables << " sparse tables, "
+                << report.sparse_cells << " sparse cells\n";
+    }
+
+    if (report.dead_dimensions) {
+        ++trace << report.dead_dimensions << " dead dimensions, "
+                << report.direct_methods << " direct calls\n";
+    }
 }
 
 } // namespace detail
@@ -25,8 +25,10 @@ class static_list {
 
       protected:
         friend class static_list;
-        T* prev_ptr;
-        T* next_ptr;
+        // Also null for nodes with automatic storage duration, e.g. a
+        // 'use_classes' object in a scope.
+        T* prev_ptr = nullptr;
+        T* next_ptr = nullptr;
     };
 
     void push_back(T& node) {
@@ -14,6 +14,7 @@
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <numeric>
 #include <regex>
 #include <set>
@@ -34,6 +35,12 @@ class generator {
 #endif
     template<class Policy = YOMM2_DEFAULT_POLICY>
     const generator& write_static_offsets(std::ostream& os) const;
+    template<class Policy = YOMM2_DEFAULT_POLICY>
+    const generator& write_static_guards(
+        std::istream& profile, std::ostream& os, double min_share = 0.5) const;
+    template<class Compiler>
+    const generator&
+    write_dispatch_functions(const Compiler& compiler, std::ostream& os) const;
     template<class Compiler>
     static void
     encode_dispatch_data(const Compiler& compiler, std::ostream& os);
@@ -45,6 +52,10 @@ class generator {
     void write_static_offsets(
         const detail::method_info& method, std::ostream& os) const;
 
+    static std::string demangle(type_id type);
+    static std::string
+    definition_expression(const detail::definition_info& spec);
+
     static uint16_t encode_group(
         const detail::generic_compiler::method* method,
         const detail::generic_compiler::vtbl_entry& entry);
@@ -256,6 +267,223 @@ void generator::write_static_offsets(
     os << "}; };\n";
 }
 
+template<class Policy>
+const generator& generator::write_static_guards(
+    std::istream& is, std::ostream& os, double min_share) const {
+    using namespace detail;
+
+    call_profile_type profile;
+    read_call_profile(is, profile);
+
+    for (auto& method : Policy::methods) {
+        if (method.arity() != 1) {
+            continue;
+        }
+
+        auto method_name = demangle(method.method_type);
+        std::size_t calls = 0, hot_calls = 0;
+        std::string hot_class;
+
+        for (auto iter = profile.lower_bound({method_name, ""});
+             iter != profile.end() && iter->first.first == method_name;
+             ++iter) {
+            calls += iter->second;
+
+            if (iter->second > hot_calls) {
+                hot_calls = iter->second;
+                hot_class = iter->first.second;
+            }
+        }
+
+        if (calls == 0 || hot_calls < min_share * calls) {
+            continue;
+        }
+
+        // Find the definition that 'update' selected for the hot class.
+        auto cls = std::find_if(
+            Policy::classes.begin(), Policy::classes.end(),
+            [&](auto& cls) { return demangle(cls.type) == hot_class; });
+
+        if (cls == Policy::classes.end()) {
+            continue;
+        }
+
+        auto pf = cls->vptr()[method.slots_strides_ptr[0]];
+        auto spec = std::find_if(
+            method.specs.begin(), method.specs.end(),
+            [pf](auto& spec) { return std::uintptr_t(spec.pf) == pf; });
+
+        if (spec == method.specs.end()) {
+            // not implemented, or ambiguous
+            continue;
+        }
+
+        auto function = definition_expression(*spec);
+
+        if (function.empty() ||
+            hot_class.find("(anonymous namespace)") != std::string::npos) {
+            os << "// " << method_name << ": cannot name the definition for "
+               << hot_class << "\n";
+            continue;
+        }
+
+        os << "template<> struct yorel::yomm2::detail::static_guard<"
+           << method_name << "> {using type = " << hot_class
+           << "; static constexpr auto function = " << function << ";};\n";
+    }
+
+    return *this;
+}
+
+inline std::string generator::demangle(type_id type) {
+    return boost::core::demangle(
+        reinterpret_cast<const std::type_info*>(type)->name());
+}
+
+// An expression that designates the function of a definition, or an empty
+// string if the definition is not a named function.
+inline std::string
+generator::definition_expression(const detail::definition_info& spec) {
+    using namespace detail;
+
+    if (!spec.registrar) {
+        return {};
+    }
+
+    // The name of the function is the argument of 'add_function'.
+    auto registrar = demangle(spec.registrar);
+    auto function_pos = registrar.rfind("::add_function<");
+    auto function_last = registrar.rfind('>');
+
+    if (function_pos == std::string::npos ||
+        function_last == std::string::npos ||
+        registrar.find("(anonymous namespace)") != std::string::npos) {
+        return {};
+    }
+
+    function_pos += sizeof("::add_function<") - 1;
+
+    while (registrar[function_last - 1] == ' ') {
+        --function_last;
+    }
+
+    auto function =
+        registrar.substr(function_pos, function_last - function_pos);
+
+    // The address of a function may be demangled as '&(f(params))'.
+    if (starts_with(function, "&(") && function.back() == ')') {
+        function = function.substr(2, function.size() - 3);
+        auto params_pos = function.size();
+
+        for (int depth = 0; params_pos--;) {
+            if (function[params_pos] == ')') {
+                ++depth;
+            } else if (function[params_pos] == '(' && !--depth) {
+                break;
+            }
+        }
+
+        function = "&" + function.substr(0, params_pos);
+    }
+
+    // Remove ABI tags, e.g. '[abi:cxx11]' for a function returning a string.
+    function = std::regex_replace(function, std::regex(R"(\[abi:\w+\])"), "");
+
+    // Select the right overload, if the function is overloaded.
+    return "static_cast<" + demangle(spec.type) + ">(" + function + ")";
+}
+
+template<class Compiler>
+const generator& generator::write_dispatch_functions(
+    const Compiler& compiler, std::ostream& os) const {
+    using namespace detail;
+
+    using class_ = generic_compiler::class_;
+    using definition = generic_compiler::definition;
+
+    for (auto& m : compiler.methods) {
+        auto method_name = demangle(m.info->method_type);
+
+        if (method_name.find("(anonymous namespace)") != std::string::npos) {
+            os << "// " << method_name << ": cannot name the method\n";
+            continue;
+        }
+
+        // For each virtual parameter, the groups of the class indices, read
+        // in front of the v-tables. Classes that share a v-table share an
+        // index, and belong to the same group.
+        std::vector<std::map<std::size_t, std::set<std::uintptr_t>>> groups(
+            m.arity());
+
+        for (std::size_t dim = 0; dim < m.arity(); ++dim) {
+            std::set<std::uintptr_t> seen;
+
+            for (const class_* cls : m.vp[dim]->covariant_classes) {
+                auto index = cls->vptr()[-1];
+
+                if (seen.insert(index).second) {
+                    auto& entry = cls->vtbl[m.slots[dim] - cls->first_slot];
+                    groups[dim][entry.group_index].insert(index);
+                }
+            }
+        }
+
+        os << "template<> struct yorel::yomm2::detail::dispatch_function<"
+           << method_name << "> {\n"
+           << "static constexpr std::size_t arity = " << m.arity() << ";\n"
+           << "template<class Call> static decltype(auto) dispatch("
+           << "const std::uintptr_t* const* vptrs, Call call) {\n";
+
+        auto write_switch = [&](auto& write_switch, std::size_t dim,
+                                std::size_t cell) -> void {
+            os << "switch (vptrs[" << dim << "][-1]) {\n";
+
+            for (auto& [group, indices] : groups[dim]) {
+                auto group_cell =
+                    cell + group * (dim == 0 ? 1 : m.strides[dim - 1]);
+                const definition* spec = nullptr;
+                std::string function;
+
+                if (dim + 1 == m.arity()) {
+                    spec = m.dispatch_table[group_cell];
+
+                    if (spec == &m.not_implemented || spec == &m.ambiguous) {
+                        continue;
+                    }
+
+                    function = definition_expression(*spec->info);
+
+                    if (function.empty()) {
+                        continue;
+                    }
+                }
+
+                for (auto index : indices) {
+                    os << "case " << index << ":\n";
+                }
+
+                if (dim + 1 == m.arity()) {
+                    os << "return call(std::integral_constant<"
+                       << demangle(spec->info->type) << ", "
+                       << function << ">());\n";
+                } else {
+                    write_switch(write_switch, dim + 1, group_cell);
+                    os << "break;\n";
+                }
+            }
+
+            os << "}\n";
+        };
+
+        write_switch(write_switch, 0, 0);
+
+        // not implemented, ambiguous, unnamed, or unknown class
+        os << "return call();\n}\n};\n";
+    }
+
+    return *this;
+}
+
 uint16_t generator::encode_group(
     const detail::generic_compiler::method* method,
     const detail::generic_compiler::vtbl_entry& entry) {
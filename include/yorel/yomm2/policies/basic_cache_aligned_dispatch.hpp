@@ -0,0 +1,35 @@
+
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_CACHE_ALIGNED_DISPATCH_HPP
+#define YOREL_YOMM2_POLICY_BASIC_CACHE_ALIGNED_DISPATCH_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Lay out the dispatch data so that each v-table or dispatch table that fits
+// in a cache line does not straddle two, and write each dispatch table just
+// before the first v-table that points into it.
+template<class Policy, std::size_t LineSize = 64>
+struct yOMM2_API_gcc basic_cache_aligned_dispatch
+    : virtual cache_aligned_dispatch {
+    static_assert(LineSize % sizeof(std::uintptr_t) == 0);
+
+    static constexpr std::size_t line_size = LineSize;
+
+    struct report {
+        std::size_t padding_words = 0;
+    };
+};
+
+}
+}
+}
+
+#endif
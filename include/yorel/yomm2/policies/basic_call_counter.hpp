@@ -0,0 +1,85 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_CALL_COUNTER_HPP
+#define YOREL_YOMM2_POLICY_BASIC_CALL_COUNTER_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Count the calls to each method, per class of each virtual argument, i.e.
+// the number of times a call reads the method's entry in the v-table of a
+// class. 'write_profile' writes the counts in the format read by
+// 'basic_call_profile'. Counting takes a lock: this facet is meant for
+// training runs. Calls that are not resolved, like hits in an 'inline_cache'
+// or calls through a 'bound_call', are not counted.
+template<class Policy>
+struct yOMM2_API_gcc basic_call_counter : virtual call_counter {
+    static std::map<
+        std::pair<const detail::method_info*, const std::uintptr_t*>,
+        std::size_t>
+        call_counts;
+    static std::mutex call_counts_mutex;
+
+    static void
+    count_call(const detail::method_info& method, const std::uintptr_t* vptr) {
+        std::lock_guard<std::mutex> lock(call_counts_mutex);
+        ++call_counts[{&method, vptr}];
+    }
+
+    // The counts are keyed on the v-tables installed by the last 'update':
+    // write the profile before calling 'update' again. Classes that share a
+    // v-table cannot be told apart, the calls are attributed to all of them.
+    template<class Stream>
+    static void write_profile(Stream& os) {
+        std::map<const std::uintptr_t*, std::set<std::string>> class_names;
+
+        for (auto& cls : Policy::classes) {
+            std::ostringstream name;
+            Policy::type_name(cls.type, name);
+            class_names[cls.vptr()].insert(name.str());
+        }
+
+        std::map<std::pair<std::string, std::string>, std::size_t> profile;
+        std::lock_guard<std::mutex> lock(call_counts_mutex);
+
+        for (auto& [key, calls] : call_counts) {
+            std::ostringstream method_name;
+            Policy::type_name(key.first->method_type, method_name);
+
+            for (auto& class_name : class_names[key.second]) {
+                profile[{method_name.str(), class_name}] += calls;
+            }
+        }
+
+        for (auto& [key, calls] : profile) {
+            os << key.first << '\t' << key.second << '\t' << calls << '\n';
+        }
+    }
+};
+
+template<class Policy>
+std::map<
+    std::pair<const detail::method_info*, const std::uintptr_t*>, std::size_t>
+    basic_call_counter<Policy>::call_counts;
+
+template<class Policy>
+std::mutex basic_call_counter<Policy>::call_counts_mutex;
+
+}
+}
+}
+
+#endif
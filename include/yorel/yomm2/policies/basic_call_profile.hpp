@@ -0,0 +1,98 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_CALL_PROFILE_HPP
+#define YOREL_YOMM2_POLICY_BASIC_CALL_PROFILE_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace yorel {
+namespace yomm2 {
+namespace detail {
+
+using call_profile_type =
+    std::map<std::pair<std::string, std::string>, std::size_t>;
+
+// Add the calls read from 'is' to 'profile'. Returns false if a line is
+// malformed; the lines before it have been added.
+template<class Stream>
+bool read_call_profile(Stream& is, call_profile_type& profile) {
+    std::string line;
+
+    while (std::getline(is, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        auto class_pos = line.find('\t');
+
+        if (class_pos == std::string::npos) {
+            return false;
+        }
+
+        auto calls_pos = line.find('\t', class_pos + 1);
+
+        if (calls_pos == std::string::npos) {
+            return false;
+        }
+
+        char* end;
+        auto calls = std::strtoull(line.c_str() + calls_pos + 1, &end, 10);
+
+        if (end == line.c_str() + calls_pos + 1 || *end) {
+            return false;
+        }
+
+        profile[{line.substr(0, class_pos),
+                 line.substr(class_pos + 1, calls_pos - class_pos - 1)}] +=
+            calls;
+    }
+
+    return true;
+}
+
+} // namespace detail
+
+namespace policy {
+
+// Lay out the dispatch data according to a call profile, typically written by
+// 'basic_call_counter' during a training run. The methods called most often
+// get the first slots of the v-tables, and the v-tables and dispatch tables
+// used most often are placed first, next to each other. A profile contains one
+// line per method and class: the name of the method, the name of the class,
+// and the number of calls, separated by tabs. Entries that name an unknown
+// method or class are ignored.
+template<class Policy>
+struct yOMM2_API_gcc basic_call_profile : virtual call_profile {
+    static detail::call_profile_type profile;
+
+    // Add the calls read from 'is' to 'profile'. Returns false if a line is
+    // malformed; the lines before it have been added.
+    template<class Stream>
+    static bool read_profile(Stream& is) {
+        return detail::read_call_profile(is, profile);
+    }
+
+    struct report {
+        // calls in the profile, for known methods and classes
+        std::size_t profiled_calls = 0;
+        // profile entries for unknown methods or classes
+        std::size_t stale_profile_entries = 0;
+    };
+};
+
+template<class Policy>
+detail::call_profile_type basic_call_profile<Policy>::profile;
+
+}
+}
+}
+
+#endif
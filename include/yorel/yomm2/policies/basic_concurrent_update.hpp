@@ -0,0 +1,310 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_CONCURRENT_UPDATE_HPP
+#define YOREL_YOMM2_POLICY_BASIC_CONCURRENT_UPDATE_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Allow 'update' to run while other threads call methods. Each 'update' builds
+// the vptrs, the slots and strides, and the dispatch tables in a new image,
+// then publishes it with an atomic store. A method call uses the image that
+// was current when it started, from the lookup of the vptrs to the dispatch
+// table. The images replaced by an 'update' are released once the calls that
+// started before it have returned. The 'update's must not overlap.
+template<class Policy>
+struct yOMM2_API_gcc basic_concurrent_update : virtual concurrent_update {
+    // The image header. The buckets, pairs of a type id and a vptr, follow.
+    enum {
+        hash_mult_index,
+        hash_shift_index,
+        buckets_index,
+        methods_index, // the offset of the slots and strides of each method
+        header_words
+    };
+
+    // The state of a thread that calls methods.
+    struct reader {
+        // the epoch when the current call started, or zero between calls
+        std::atomic<std::size_t> epoch{0};
+        std::atomic<bool> in_use{true};
+        std::uintptr_t* image = nullptr;
+        std::size_t depth = 0;
+        reader* next = nullptr;
+    };
+
+    // Pins the current image for the duration of a method call. Nested calls
+    // use the image pinned by the outermost call.
+    class read_guard {
+        reader& self;
+
+      public:
+        read_guard() : self(this_reader()) {
+            if (self.depth++ == 0) {
+                self.epoch.store(
+                    global_epoch.load(std::memory_order_relaxed),
+                    std::memory_order_seq_cst);
+                self.image = current_image.load(std::memory_order_seq_cst);
+            }
+        }
+
+        ~read_guard() {
+            if (--self.depth == 0) {
+                self.image = nullptr;
+                self.epoch.store(0, std::memory_order_release);
+            }
+        }
+    };
+
+    static std::atomic<std::uintptr_t*> current_image;
+    static std::atomic<std::size_t> global_epoch;
+    static std::atomic<reader*> readers;
+    // the images replaced by an 'update', with the epoch of the replacement
+    static std::vector<std::pair<std::size_t, std::unique_ptr<std::uintptr_t[]>>>
+        retired_images;
+    // the image being built by 'update'
+    static std::unique_ptr<std::uintptr_t[]> next_image;
+    // the number of method indexes handed out, see 'method_info::image_index'
+    static std::size_t method_indexes;
+
+    // Allocates the next image, and returns the address of 'size' words for
+    // the dispatch tables and the v-tables.
+    template<typename ForwardIterator>
+    static std::uintptr_t* initialize_image(
+        ForwardIterator first, ForwardIterator last, std::size_t size) {
+        std::size_t buckets;
+
+        if constexpr (has_facet<Policy, type_hash>) {
+            Policy::hash_initialize(first, last);
+            buckets = Policy::hash_length;
+        } else {
+            buckets = 0;
+
+            for (auto iter = first; iter != last; ++iter) {
+                for (auto type_iter = iter->type_id_begin();
+                     type_iter != iter->type_id_end(); ++type_iter) {
+                    buckets = (std::max)(buckets, *type_iter);
+                }
+            }
+
+            ++buckets;
+        }
+
+        std::size_t slots_strides_size = 0;
+
+        for (auto& method : Policy::methods) {
+            if (!method.image_index) {
+                method.image_index = ++method_indexes;
+            }
+
+            slots_strides_size += 2 * method.arity() + 1;
+        }
+
+        auto methods_offset = header_words + 2 * buckets;
+        next_image.reset(new std::uintptr_t
+                             [methods_offset + method_indexes + 1 +
+                              slots_strides_size + size]());
+        auto image = next_image.get();
+
+        if constexpr (has_facet<Policy, type_hash>) {
+            image[hash_mult_index] = Policy::hash_mult;
+            image[hash_shift_index] = Policy::hash_shift;
+        }
+
+        image[buckets_index] = buckets;
+        image[methods_index] = methods_offset;
+
+        auto slots_strides = image + methods_offset + method_indexes + 1;
+
+        for (auto& method : Policy::methods) {
+            image[methods_offset + method.image_index] =
+                std::uintptr_t(slots_strides);
+            slots_strides += 2 * method.arity() + 1;
+        }
+
+        return slots_strides;
+    }
+
+    // Returns where to copy the slots and strides of 'method' in the image
+    // being built.
+    static std::size_t* next_slots_strides(const detail::method_info& method) {
+        auto image = next_image.get();
+
+        return reinterpret_cast<std::size_t*>(
+            image[image[methods_index] + method.image_index]);
+    }
+
+    // Fills the buckets of the image being built, and makes it current.
+    template<typename ForwardIterator>
+    static void publish_vptrs(ForwardIterator first, ForwardIterator last) {
+        auto image = next_image.get();
+
+        for (auto iter = first; iter != last; ++iter) {
+            for (auto type_iter = iter->type_id_begin();
+                 type_iter != iter->type_id_end(); ++type_iter) {
+                auto bucket = image + header_words + 2 * bucket_index(image, *type_iter);
+                bucket[0] = *type_iter;
+                bucket[1] = std::uintptr_t(iter->vptr());
+            }
+        }
+
+        auto previous = current_image.exchange(
+            next_image.release(), std::memory_order_seq_cst);
+
+        if (previous) {
+            retired_images.emplace_back(
+                global_epoch.fetch_add(1, std::memory_order_seq_cst),
+                std::unique_ptr<std::uintptr_t[]>(previous));
+        }
+
+        release_images();
+    }
+
+    // Releases the retired images that no call uses anymore. Called by
+    // 'update'; call it again to release the images that were still in use
+    // then.
+    static void release_images() {
+        auto oldest = global_epoch.load(std::memory_order_seq_cst);
+
+        for (auto iter = readers.load(std::memory_order_acquire); iter;
+             iter = iter->next) {
+            auto epoch = iter->epoch.load(std::memory_order_seq_cst);
+
+            if (epoch && epoch < oldest) {
+                oldest = epoch;
+            }
+        }
+
+        // An image retired at epoch E may be used by the calls that started
+        // at epoch E or earlier.
+        std::size_t kept = 0;
+
+        for (auto& retired : retired_images) {
+            if (retired.first >= oldest) {
+                retired_images[kept++] = std::move(retired);
+            }
+        }
+
+        retired_images.resize(kept);
+    }
+
+    template<class Class>
+    static const std::uintptr_t* dynamic_vptr(const Class& arg) {
+        auto image = pinned_image();
+        auto type = Policy::dynamic_type(arg);
+        auto index = bucket_index(image, type);
+        auto bucket = image + header_words + 2 * index;
+
+        if constexpr (has_facet<Policy, runtime_checks>) {
+            if (index >= image[buckets_index] || bucket[0] != type) {
+                if constexpr (has_facet<Policy, error_handler>) {
+                    unknown_class_error error;
+                    error.context = unknown_class_error::call;
+                    error.type = type;
+                    Policy::error(error);
+                }
+
+                abort();
+            }
+        }
+
+        return reinterpret_cast<const std::uintptr_t*>(bucket[1]);
+    }
+
+    static const std::size_t* slots_strides(const detail::method_info& method) {
+        auto image = pinned_image();
+
+        return reinterpret_cast<const std::size_t*>(
+            image[image[methods_index] + method.image_index]);
+    }
+
+  private:
+    static std::size_t bucket_index(const std::uintptr_t* image, type_id type) {
+        if constexpr (has_facet<Policy, type_hash>) {
+            return (image[hash_mult_index] * type) >> image[hash_shift_index];
+        } else {
+            return type;
+        }
+    }
+
+    // Outside of a method call, e.g. for a 'virtual_ptr', use the latest
+    // image.
+    static const std::uintptr_t* pinned_image() {
+        auto image = this_reader().image;
+
+        return image ? image : current_image.load(std::memory_order_acquire);
+    }
+
+    // Hands the record of a thread that exited to the next new thread, or
+    // adds a new record to the list.
+    struct reader_handle {
+        reader* self;
+
+        reader_handle() {
+            for (auto iter = readers.load(std::memory_order_acquire); iter;
+                 iter = iter->next) {
+                bool in_use = false;
+
+                if (iter->in_use.compare_exchange_strong(in_use, true)) {
+                    self = iter;
+                    return;
+                }
+            }
+
+            self = new reader;
+            self->next = readers.load(std::memory_order_relaxed);
+
+            while (!readers.compare_exchange_weak(
+                self->next, self, std::memory_order_release,
+                std::memory_order_relaxed)) {
+            }
+        }
+
+        ~reader_handle() {
+            self->in_use.store(false, std::memory_order_release);
+        }
+    };
+
+    static reader& this_reader() {
+        static thread_local reader_handle handle;
+
+        return *handle.self;
+    }
+};
+
+template<class Policy>
+std::atomic<std::uintptr_t*> basic_concurrent_update<Policy>::current_image;
+
+template<class Policy>
+std::atomic<std::size_t> basic_concurrent_update<Policy>::global_epoch{1};
+
+template<class Policy>
+std::atomic<typename basic_concurrent_update<Policy>::reader*>
+    basic_concurrent_update<Policy>::readers;
+
+template<class Policy>
+std::vector<std::pair<std::size_t, std::unique_ptr<std::uintptr_t[]>>>
+    basic_concurrent_update<Policy>::retired_images;
+
+template<class Policy>
+std::unique_ptr<std::uintptr_t[]> basic_concurrent_update<Policy>::next_image;
+
+template<class Policy>
+std::size_t basic_concurrent_update<Policy>::method_indexes;
+
+}
+}
+}
+
+#endif
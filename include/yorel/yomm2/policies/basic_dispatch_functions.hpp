@@ -0,0 +1,30 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_DISPATCH_FUNCTIONS_HPP
+#define YOREL_YOMM2_POLICY_BASIC_DISPATCH_FUNCTIONS_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Store a dense class index just before each v-table, and dispatch the
+// methods that have a 'detail::dispatch_function', typically written by
+// 'generator::write_dispatch_functions', by switching on the indices. Classes
+// that share a v-table share an index.
+template<class Policy>
+struct yOMM2_API_gcc basic_dispatch_functions : virtual dispatch_functions {
+    struct report {
+        std::size_t class_indices = 0;
+    };
+};
+
+}
+}
+}
+
+#endif
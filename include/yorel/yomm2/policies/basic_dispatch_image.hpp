@@ -0,0 +1,98 @@
+
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_DISPATCH_IMAGE_HPP
+#define YOREL_YOMM2_POLICY_BASIC_DISPATCH_IMAGE_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Store the vptrs, indexed by type id or hash, followed by the dispatch tables
+// and the v-tables, in a single, statically allocated, cache line aligned
+// array of 'Words' words. Finding a vptr takes one load at a fixed address,
+// instead of two for 'vptr_vector': one for the address of the vector's
+// buffer, and one for the vptr.
+template<class Policy, std::size_t Words = 16384>
+struct yOMM2_API_gcc basic_dispatch_image : virtual dispatch_image {
+    static constexpr std::size_t image_size = Words;
+    static constexpr std::size_t cache_line_words = 64 / sizeof(std::uintptr_t);
+
+    alignas(64) static std::uintptr_t image[Words];
+
+    // Returns the number of words reserved for the vptrs at the beginning of
+    // the image, rounded up to a multiple of the cache line size.
+    template<typename ForwardIterator>
+    static std::size_t
+    initialize_image(ForwardIterator first, ForwardIterator last) {
+        std::size_t size;
+
+        if constexpr (has_facet<Policy, type_hash>) {
+            Policy::hash_initialize(first, last);
+            size = Policy::hash_length;
+        } else {
+            size = 0;
+
+            for (auto iter = first; iter != last; ++iter) {
+                for (auto type_iter = iter->type_id_begin();
+                     type_iter != iter->type_id_end(); ++type_iter) {
+                    size = (std::max)(size, *type_iter);
+                }
+            }
+
+            ++size;
+        }
+
+        if constexpr (has_facet<Policy, indirect_vptr>) {
+            Policy::indirect_vptrs.resize(size);
+        }
+
+        return (size + cache_line_words - 1) / cache_line_words *
+            cache_line_words;
+    }
+
+    template<typename ForwardIterator>
+    static void publish_vptrs(ForwardIterator first, ForwardIterator last) {
+        for (auto iter = first; iter != last; ++iter) {
+            for (auto type_iter = iter->type_id_begin();
+                 type_iter != iter->type_id_end(); ++type_iter) {
+                auto index = *type_iter;
+
+                if constexpr (has_facet<Policy, type_hash>) {
+                    index = Policy::hash_type_id(index);
+                }
+
+                image[index] = std::uintptr_t(iter->vptr());
+
+                if constexpr (has_facet<Policy, indirect_vptr>) {
+                    Policy::indirect_vptrs[index] = iter->indirect_vptr();
+                }
+            }
+        }
+    }
+
+    template<class Class>
+    static const std::uintptr_t* dynamic_vptr(const Class& arg) {
+        auto index = Policy::dynamic_type(arg);
+
+        if constexpr (has_facet<Policy, type_hash>) {
+            index = Policy::hash_type_id(index);
+        }
+
+        return reinterpret_cast<const std::uintptr_t*>(image[index]);
+    }
+};
+
+template<class Policy, std::size_t Words>
+alignas(64) std::uintptr_t basic_dispatch_image<Policy, Words>::image[Words];
+
+}
+}
+}
+
+#endif
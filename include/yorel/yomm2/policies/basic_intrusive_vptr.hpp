@@ -0,0 +1,35 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_INTRUSIVE_VPTR_HPP
+#define YOREL_YOMM2_POLICY_BASIC_INTRUSIVE_VPTR_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Fetch the vptr from the object itself, via its 'yomm2_vptr()' member
+// function, typically provided by the 'with_vptr' mixin. If the policy also
+// has the 'indirect_vptr' facet, 'yomm2_vptr()' returns a pointer to the
+// policy's 'static_vptr<Class>', which 'update' overwrites in place.
+template<class Policy>
+struct yOMM2_API_gcc basic_intrusive_vptr : virtual intrusive_vptr {
+    template<class Class>
+    static const std::uintptr_t* dynamic_vptr(const Class& arg) {
+        if constexpr (has_facet<Policy, indirect_vptr>) {
+            return *arg.yomm2_vptr();
+        } else {
+            return arg.yomm2_vptr();
+        }
+    }
+};
+
+}
+}
+}
+
+#endif
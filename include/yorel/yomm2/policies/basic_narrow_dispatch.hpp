@@ -0,0 +1,40 @@
+
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_NARROW_DISPATCH_HPP
+#define YOREL_YOMM2_POLICY_BASIC_NARROW_DISPATCH_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Store the cells of the multi-method dispatch tables in 'cell_data', as
+// 'Cell' indices into an array of function pointers at the beginning of
+// 'dispatch_data', instead of as function pointers.
+template<class Policy, typename Cell = std::uint16_t>
+struct yOMM2_API_gcc basic_narrow_dispatch : virtual narrow_dispatch {
+    static_assert(std::is_unsigned_v<Cell>);
+
+    using cell_type = Cell;
+
+    struct report {
+        // can be negative for very small tables
+        std::ptrdiff_t dispatch_bytes_saved;
+    };
+
+    static std::vector<Cell> cell_data;
+};
+
+template<class Policy, typename Cell>
+std::vector<Cell> basic_narrow_dispatch<Policy, Cell>::cell_data;
+
+}
+}
+}
+
+#endif
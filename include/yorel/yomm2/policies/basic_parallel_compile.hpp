@@ -0,0 +1,78 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_PARALLEL_COMPILE_HPP
+#define YOREL_YOMM2_POLICY_BASIC_PARALLEL_COMPILE_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Build the dispatch tables of the methods on several threads. The methods are
+// independent of each other; each one is built by a single thread, and the
+// results are merged in the same order as in a serial build, thus the layout
+// of the dispatch data does not depend on the number of threads.
+template<class Policy>
+struct yOMM2_API_gcc basic_parallel_compile : virtual parallel_compile {
+    // the number of threads, or zero for one per hardware thread
+    static std::size_t threads;
+
+    struct report {
+        // the number of threads that built the dispatch tables
+        std::size_t compile_threads = 0;
+    };
+
+    // Calls 'fn' for each index in [0, size), from as many threads as
+    // configured, including the calling thread. Returns the number of
+    // threads.
+    template<typename Function>
+    static std::size_t parallel_for(std::size_t size, Function fn) {
+        std::size_t count = threads;
+
+        if (count == 0) {
+            count = (std::max)(std::thread::hardware_concurrency(), 1u);
+        }
+
+        count = (std::min)(count, size);
+
+        std::atomic<std::size_t> next{0};
+
+        auto work = [&]() {
+            for (auto index = next++; index < size; index = next++) {
+                fn(index);
+            }
+        };
+
+        std::vector<std::thread> workers;
+
+        for (std::size_t i = 1; i < count; ++i) {
+            workers.emplace_back(work);
+        }
+
+        work();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        return count;
+    }
+};
+
+template<class Policy>
+std::size_t basic_parallel_compile<Policy>::threads;
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,31 @@
+
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_BASIC_SPARSE_DISPATCH_HPP
+#define YOREL_YOMM2_POLICY_BASIC_SPARSE_DISPATCH_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Compress the dispatch tables that have more than 'MaxDenseCells' cells,
+// if that makes them smaller. A compressed table has one row per
+// combination of the groups of all the virtual arguments but the last.
+// Each row holds the definition that occurs most often in it, and a pointer
+// into an array where the other cells of all the rows are interleaved, each
+// tagged with the row that owns it (row displacement).
+template<class Policy, std::size_t MaxDenseCells = 4096>
+struct yOMM2_API_gcc basic_sparse_dispatch : virtual sparse_dispatch {
+    static constexpr std::size_t max_dense_cells = MaxDenseCells;
+};
+
+}
+}
+}
+
+#endif
@@ -26,6 +26,7 @@ struct class_info : static_list<class_info>::static_link {
     std::uintptr_t** static_vptr;
     type_id *first_base, *last_base;
     bool is_abstract{false};
+    bool is_resolved{false}; // for deferred_static_rtti
 
     const std::uintptr_t* vptr() const {
         return *static_vptr;
@@ -53,6 +54,7 @@ struct definition_info : static_list<definition_info>::static_link {
     ~definition_info();
     method_info* method; // for the destructor, to remove definition
     type_id type;        // of the function, for trace
+    type_id registrar;   // of the 'add_function', for the generator
     void** next;
     type_id *vp_begin, *vp_end;
     void* pf;
@@ -123,9 +125,19 @@ struct static_offset_error : error {
 struct static_slot_error : static_offset_error {};
 struct static_stride_error : static_offset_error {};
 
+struct static_guard_error : error {
+    type_id method;
+    type_id type;
+};
+
+struct dispatch_function_error : error {
+    type_id method;
+};
+
 using error_type = std::variant<
     error, resolution_error, unknown_class_error, hash_search_error,
-    method_table_error, static_slot_error, static_stride_error>;
+    method_table_error, static_slot_error, static_stride_error,
+    static_guard_error, dispatch_function_error>;
 
 using error_handler_type = std::function<void(const error_type& error)>;
 
@@ -148,13 +160,24 @@ struct abstract_policy {};
 struct error_handler {};
 struct runtime_checks {};
 struct indirect_vptr {};
+struct compact_vptr {};
+struct narrow_dispatch {};
+struct sparse_dispatch {};
+struct cache_aligned_dispatch {};
+struct call_counter {};
+struct call_profile {};
+struct dispatch_functions {};
 struct type_hash {};
 struct vptr_placement {};
 struct external_vptr : virtual vptr_placement {};
+struct dispatch_image : virtual external_vptr {};
+struct concurrent_update : virtual external_vptr {};
+struct intrusive_vptr : virtual vptr_placement {};
 struct error_output {};
 struct trace_output {};
 
 struct deferred_static_rtti;
+struct closed_rtti;
 struct debug;
 struct release;
 struct debug_shared;
@@ -165,6 +188,8 @@ struct yOMM2_API_gcc basic_domain : detail::domain, detail::method_tables<Key> {
     static detail::class_catalog classes;
     static detail::method_catalog methods;
     static std::vector<std::uintptr_t> dispatch_data;
+    // incremented each time dispatch tables are installed
+    static std::size_t epoch;
 };
 
 template<class Key>
@@ -176,6 +201,9 @@ detail::method_catalog basic_domain<Key>::methods;
 template<class Key>
 std::vector<std::uintptr_t> basic_domain<Key>::dispatch_data;
 
+template<class Key>
+std::size_t basic_domain<Key>::epoch;
+
 template<typename Policy, class Facet>
 struct rebind_facet {
     using type = Facet;
@@ -218,6 +246,9 @@ struct basic_policy : virtual abstract_policy,
                 Facet>,
             Policy>>;
 
+    template<class... MoreFacets>
+    using add = basic_policy<Policy, Facets..., MoreFacets...>;
+
     template<class Base>
     using remove = boost::mp11::mp_apply<
         basic_policy,
@@ -244,6 +275,7 @@ struct rtti {
 };
 
 struct deferred_static_rtti : virtual rtti {};
+struct closed_rtti : virtual rtti {};
 
 } // namespace policy
 
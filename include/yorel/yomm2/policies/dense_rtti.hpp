@@ -0,0 +1,70 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_DENSE_RTTI_HPP
+#define YOREL_YOMM2_POLICY_DENSE_RTTI_HPP
+
+#include <yorel/yomm2/policies/core.hpp>
+
+namespace yorel {
+namespace yomm2 {
+
+namespace detail {
+
+template<class Class, typename = void>
+constexpr bool has_yomm2_type_id = false;
+
+template<class Class>
+constexpr bool has_yomm2_type_id<
+    Class,
+    std::void_t<decltype(std::declval<const Class&>().yomm2_type_id())>> = true;
+
+} // namespace detail
+
+namespace policy {
+
+// Number the classes registered in 'Policy' 0, 1, 2... as 'update' resolves
+// their (deferred) static type ids. Without a 'type_hash' facet,
+// 'vptr_vector' indexes its table - exactly one entry per class - with the id
+// directly. Objects report their id via a 'yomm2_type_id()' member function,
+// typically provided by the 'with_type_id' mixin; objects of other classes
+// are assumed to be of their static type. Methods, definitions and other
+// non-class types get ids outside of the dense range.
+template<class Policy>
+struct yOMM2_API_gcc dense_rtti : virtual deferred_static_rtti {
+    static type_id next_type_id;
+
+    template<class Class>
+    static type_id static_type() {
+        if constexpr (
+            std::is_class_v<Class> &&
+            !std::is_base_of_v<detail::method_info, Class> &&
+            !std::is_base_of_v<abstract_policy, Class>) {
+            static type_id id = next_type_id++;
+            return id;
+        } else {
+            static char id;
+            return reinterpret_cast<type_id>(&id);
+        }
+    }
+
+    template<class Class>
+    static type_id dynamic_type(const Class& obj) {
+        if constexpr (detail::has_yomm2_type_id<Class>) {
+            return obj.yomm2_type_id();
+        } else {
+            return static_type<Class>();
+        }
+    }
+};
+
+template<class Policy>
+type_id dense_rtti<Policy>::next_type_id;
+
+}
+}
+}
+
+#endif
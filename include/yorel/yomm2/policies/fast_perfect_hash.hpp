@@ -7,6 +7,7 @@
 #ifndef YOREL_YOMM2_POLICY_FAST_PERFECT_HASH_HPP
 #define YOREL_YOMM2_POLICY_FAST_PERFECT_HASH_HPP
 
+#include <limits>
 #include <random>
 
 #include <yorel/yomm2/policies/core.hpp>
@@ -46,8 +47,43 @@ struct yOMM2_API_gcc fast_perfect_hash : virtual type_hash {
     static void hash_initialize(
         ForwardIterator first, ForwardIterator last,
         std::vector<type_id>& buckets);
+
+    template<typename ForwardIterator>
+    static bool fill_buckets(
+        ForwardIterator first, ForwardIterator last,
+        std::vector<type_id>& buckets);
 };
 
+// Store each type in its bucket, using the current factor. Return false if
+// two types collide.
+template<class Policy>
+template<typename ForwardIterator>
+bool fast_perfect_hash<Policy>::fill_buckets(
+    ForwardIterator first, ForwardIterator last,
+    std::vector<type_id>& buckets) {
+    std::fill(buckets.begin(), buckets.end(), static_cast<type_id>(-1));
+    hash_min = (std::numeric_limits<std::size_t>::max)();
+    hash_max = 0;
+
+    for (auto iter = first; iter != last; ++iter) {
+        for (auto type_iter = iter->type_id_begin();
+             type_iter != iter->type_id_end(); ++type_iter) {
+            auto type = *type_iter;
+            auto index = (type * hash_mult) >> hash_shift;
+            hash_min = (std::min)(hash_min, index);
+            hash_max = (std::max)(hash_max, index);
+
+            if (buckets[index] != static_cast<type_id>(-1)) {
+                return false;
+            }
+
+            buckets[index] = type;
+        }
+    }
+
+    return true;
+}
+
 template<class Policy>
 template<typename ForwardIterator>
 void fast_perfect_hash<Policy>::hash_initialize(
@@ -65,6 +101,26 @@ void fast_perfect_hash<Policy>::hash_initialize(
         }
     }
 
+    // After loading or unloading a library, the factor found by the previous
+    // 'update' is often still perfect.
+    if (hash_length) {
+        buckets.resize(std::size_t(1) << (8 * sizeof(type_id) - hash_shift));
+
+        if (fill_buckets(first, last, buckets)) {
+            hash_length = hash_max + 1;
+
+            if constexpr (trace_enabled) {
+                if (Policy::trace_enabled) {
+                    Policy::trace_stream << "  keeping " << hash_mult
+                                         << "; min = " << hash_min
+                                         << ", max = " << hash_max << "\n";
+                }
+            }
+
+            return;
+        }
+    }
+
     std::default_random_engine rnd(13081963);
     std::size_t total_attempts = 0;
     std::size_t M = 1;
@@ -92,28 +148,10 @@ void fast_perfect_hash<Policy>::hash_initialize(
         hash_length = 0;
 
         while (!found && attempts < 100000) {
-            std::fill(buckets.begin(), buckets.end(), static_cast<type_id>(-1));
             ++attempts;
             ++total_attempts;
-            found = true;
             hash_mult = uniform_dist(rnd) | 1;
-
-            for (auto iter = first; iter != last; ++iter) {
-                for (auto type_iter = iter->type_id_begin();
-                     type_iter != iter->type_id_end(); ++type_iter) {
-                    auto type = *type_iter;
-                    auto index = (type * hash_mult) >> hash_shift;
-                    hash_min = (std::min)(hash_min, index);
-                    hash_max = (std::max)(hash_max, index);
-
-                    if (buckets[index] != static_cast<type_id>(-1)) {
-                        found = false;
-                        break;
-                    }
-
-                    buckets[index] = type;
-                }
-            }
+            found = fill_buckets(first, last, buckets);
         }
 
         // metrics.hash_search_attempts = total_attempts;
@@ -0,0 +1,60 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_INDEXED_RTTI_HPP
+#define YOREL_YOMM2_POLICY_INDEXED_RTTI_HPP
+
+#include <yorel/yomm2/policies/dense_rtti.hpp>
+
+namespace yorel {
+namespace yomm2 {
+namespace detail {
+
+// Its address identifies a type that is not a class of a closed world.
+template<typename T>
+inline char indexed_rtti_anchor;
+
+} // namespace detail
+
+namespace policy {
+
+// Number the classes of a closed world 0, 1, 2... in the order of 'Classes',
+// at compile time. Other classes get the id that follows the last class.
+// Methods and policies get ids outside of this range. Objects report their id
+// via a 'yomm2_type_id()' member function, typically provided by the
+// 'with_type_id' mixin; objects of other classes are assumed to be of their
+// static type. Methods that have 'closed_definitions' are dispatched through
+// tables built at compile time, indexed by the ids.
+template<class... Classes>
+struct yOMM2_API_gcc indexed_rtti : virtual closed_rtti {
+    using closed_classes = boost::mp11::mp_list<Classes...>;
+
+    template<class Class>
+    static constexpr type_id static_type() {
+        if constexpr (
+            std::is_class_v<Class> &&
+            !std::is_base_of_v<detail::method_info, Class> &&
+            !std::is_base_of_v<abstract_policy, Class>) {
+            return boost::mp11::mp_find<closed_classes, Class>::value;
+        } else {
+            return reinterpret_cast<type_id>(&detail::indexed_rtti_anchor<Class>);
+        }
+    }
+
+    template<class Class>
+    static type_id dynamic_type(const Class& obj) {
+        if constexpr (detail::has_yomm2_type_id<Class>) {
+            return obj.yomm2_type_id();
+        } else {
+            return static_type<Class>();
+        }
+    }
+};
+
+}
+}
+}
+
+#endif
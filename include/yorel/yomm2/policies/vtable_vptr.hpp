@@ -0,0 +1,106 @@
+
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef YOREL_YOMM2_POLICY_VTABLE_VPTR_HPP
+#define YOREL_YOMM2_POLICY_VTABLE_VPTR_HPP
+
+#include <atomic>
+#include <memory>
+
+#include <yorel/yomm2/policies/vptr_vector.hpp>
+
+// Only on the Itanium C++ ABI (GCC, Clang, except on Windows), where the
+// pointer to the C++ v-table is the first word of any polymorphic object.
+#if defined(__GXX_ABI_VERSION)
+
+namespace yorel {
+namespace yomm2 {
+namespace policy {
+
+// Like 'vptr_vector', but first look up the vptr in a cache keyed on the
+// address of the object's C++ v-table, which costs a single load from the
+// object, instead of two for 'typeid'. A class has one v-table per
+// polymorphic base sub-object that does not share the v-table of its primary
+// base. There is no portable way to enumerate them, so the cache is filled
+// on the fly: on a miss, the vptr is found via 'rtti' and 'type_hash' as in
+// 'vptr_vector', and stored in an empty slot if there is one.
+// 'publish_vptrs' sizes and clears the cache.
+template<class Policy>
+struct yOMM2_API_gcc vtable_vptr : vptr_vector<Policy> {
+    struct cache_entry {
+        std::atomic<std::uintptr_t> vtable{0};
+        std::atomic<const std::uintptr_t*> vptr{nullptr};
+    };
+
+    static std::unique_ptr<cache_entry[]> vtable_cache;
+    static std::size_t vtable_cache_shift;
+
+    static constexpr std::uintptr_t vtable_hash_mult = 0x9e3779b97f4a7c15;
+    // never a v-table address, marks a slot that is being filled
+    static constexpr std::uintptr_t busy = 1;
+
+    template<typename ForwardIterator>
+    static void publish_vptrs(ForwardIterator first, ForwardIterator last) {
+        vptr_vector<Policy>::publish_vptrs(first, last);
+
+        std::size_t classes = std::distance(first, last);
+        std::size_t bits = 2; // at least four entries per class
+
+        for (auto size = classes; size >>= 1;) {
+            ++bits;
+        }
+
+        vtable_cache_shift = 8 * sizeof(std::uintptr_t) - bits;
+        vtable_cache.reset(new cache_entry[std::size_t(1) << bits]);
+    }
+
+    template<class Class>
+    static const std::uintptr_t* dynamic_vptr(const Class& arg) {
+        if constexpr (std::is_polymorphic_v<Class>) {
+            auto vtable = *reinterpret_cast<const std::uintptr_t*>(&arg);
+            auto& entry =
+                vtable_cache[(vtable * vtable_hash_mult) >> vtable_cache_shift];
+
+            if (entry.vtable.load(std::memory_order_acquire) == vtable) {
+                return entry.vptr.load(std::memory_order_relaxed);
+            }
+
+            return vtable_cache_miss(
+                entry, vtable, vptr_vector<Policy>::dynamic_vptr(arg));
+        } else {
+            return vptr_vector<Policy>::dynamic_vptr(arg);
+        }
+    }
+
+    static const std::uintptr_t* vtable_cache_miss(
+        cache_entry& entry, std::uintptr_t vtable,
+        const std::uintptr_t* vptr) {
+        std::uintptr_t empty = 0;
+
+        if (entry.vtable.compare_exchange_strong(
+                empty, busy, std::memory_order_acquire)) {
+            entry.vptr.store(vptr, std::memory_order_relaxed);
+            entry.vtable.store(vtable, std::memory_order_release);
+        }
+
+        return vptr;
+    }
+};
+
+template<class Policy>
+std::unique_ptr<typename vtable_vptr<Policy>::cache_entry[]>
+    vtable_vptr<Policy>::vtable_cache;
+
+template<class Policy>
+std::size_t vtable_vptr<Policy>::vtable_cache_shift;
+
+}
+}
+}
+
+#endif
+
+#endif
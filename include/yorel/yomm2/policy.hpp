@@ -16,10 +16,22 @@
 #include <yorel/yomm2/detail.hpp>
 
 #include <yorel/yomm2/policies/minimal_rtti.hpp>
+#include <yorel/yomm2/policies/dense_rtti.hpp>
+#include <yorel/yomm2/policies/indexed_rtti.hpp>
 #include <yorel/yomm2/policies/std_rtti.hpp>
 #include <yorel/yomm2/policies/vptr_vector.hpp>
 #include <yorel/yomm2/policies/vptr_map.hpp>
+#include <yorel/yomm2/policies/vtable_vptr.hpp>
+#include <yorel/yomm2/policies/basic_dispatch_image.hpp>
+#include <yorel/yomm2/policies/basic_concurrent_update.hpp>
 #include <yorel/yomm2/policies/basic_indirect_vptr.hpp>
+#include <yorel/yomm2/policies/basic_intrusive_vptr.hpp>
+#include <yorel/yomm2/policies/basic_narrow_dispatch.hpp>
+#include <yorel/yomm2/policies/basic_sparse_dispatch.hpp>
+#include <yorel/yomm2/policies/basic_cache_aligned_dispatch.hpp>
+#include <yorel/yomm2/policies/basic_call_counter.hpp>
+#include <yorel/yomm2/policies/basic_call_profile.hpp>
+#include <yorel/yomm2/policies/basic_dispatch_functions.hpp>
 #include <yorel/yomm2/policies/basic_error_output.hpp>
 #include <yorel/yomm2/policies/basic_trace_output.hpp>
 #include <yorel/yomm2/policies/fast_perfect_hash.hpp>
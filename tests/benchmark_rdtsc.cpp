@@ -9,20 +9,25 @@
 #include <cstddef>
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vector>
 
 using std::cout;
 using std::setw;
 using namespace yorel::yomm2;
 using namespace policy;
 
-struct intrusive : default_policy::rebind<intrusive>::remove<
-                       external_vptr>::remove<type_hash> {
-    template<class Class>
-    static auto dynamic_vptr(const Class& arg) {
-        return arg.yomm2_vptr;
-    }
+struct intrusive
+    : default_policy::rebind<intrusive>::replace<
+          external_vptr, basic_intrusive_vptr<intrusive>>::remove<type_hash> {
 };
 
+struct flat : default_policy::rebind<flat>::replace<
+                  external_vptr, basic_dispatch_image<flat>> {};
+
 struct std_unordered_map
     : default_policy::rebind<std_unordered_map>::replace<
           external_vptr, vptr_map<std_unordered_map>>::remove<type_hash> {};
@@ -44,20 +49,14 @@ struct flat_std_unordered_map
 
 namespace stat {
 
-struct Animal {
+struct Animal : with_vptr<Animal, intrusive> {
     virtual ~Animal() {
     }
 
     virtual void pet_vf() = 0;
-
-    const std::uintptr_t* yomm2_vptr = 0;
 };
 
-struct Cat : Animal {
-    Cat() {
-        yomm2_vptr = intrusive::static_vptr<Cat>;
-    }
-
+struct Cat : Animal, with_vptr<Cat, Animal> {
     void pet_vf() override { /*purr*/ };
 };
 
@@ -69,32 +68,30 @@ struct YOMM2_SYMBOL(pet_iptr);
 
 namespace dyn {
 
-struct Animal {
+struct Animal : with_vptr<Animal, intrusive> {
     virtual ~Animal() {
     }
 
     virtual void pet_vf() = 0;
-
-    const std::uintptr_t* yomm2_vptr = 0;
 };
 
-struct Cat : Animal {
-    Cat() {
-        yomm2_vptr = intrusive::static_vptr<Cat>;
-    }
-
+struct Cat : Animal, with_vptr<Cat, Animal> {
     void pet_vf() override { /*purr*/ };
 };
 
 } // namespace dyn
 
+// 'update' is called from 'main', after all the classes, methods and
+// definitions have been registered.
+std::vector<void (*)()> updates;
+
 template<class Policy>
 struct use_policy {
     use_policy() {
         YOMM2_STATIC(
             use_classes<
                 dyn::Animal, dyn::Cat, stat::Animal, stat::Cat, Policy>);
-        update<Policy>();
+        updates.push_back([]() { update<Policy>(); });
     }
 };
 
@@ -186,6 +183,19 @@ define_method(void, pet_iptr, (Cat & Cat)) {
 YOMM2_STATIC(use_policy<intrusive>);
 BENCHMARK(iptr, pet_iptr(dyn_ref));
 
+// -----------------------------------------------------------------------------
+// dispatch image
+
+declare_method(void, pet_image, (virtual_<Animal&>), flat);
+
+// Implement 'pet_image' for Cats.
+define_method(void, pet_image, (Cat & Cat)) {
+    // purr
+}
+
+YOMM2_STATIC(use_policy<flat>);
+BENCHMARK(image, pet_image(dyn_ref));
+
 // -----------------------------------------------------------------------------
 // std_unordered_map
 
@@ -260,6 +270,19 @@ define_method(void, pet_iptr, (Cat & Cat)) {
 YOMM2_STATIC(use_policy<intrusive>);
 BENCHMARK(stat_iptr, pet_iptr(stat_ref));
 
+// -----------------------------------------------------------------------------
+// dispatch image
+
+declare_method(void, pet_image, (virtual_<Animal&>), flat);
+
+// Implement 'pet_image' for Cats.
+define_method(void, pet_image, (Cat & Cat)) {
+    // purr
+}
+
+YOMM2_STATIC(use_policy<flat>);
+BENCHMARK(stat_image, pet_image(stat_ref));
+
 // -----------------------------------------------------------------------------
 // std_unordered_map
 
@@ -292,6 +315,152 @@ BENCHMARK(stat_fum, pet_fum(stat_ref));
 
 } // namespace stat
 
+// -----------------------------------------------------------------------------
+// profile-guided layout
+
+// A population of 128 classes, each with its own definitions, thus its own
+// v-table. 80% of the calls are for one class in 16. By default, the v-tables
+// are laid out in registration order, and the hot ones are spread over eight
+// cache lines. With a call profile, they are next to each other, in two lines.
+
+namespace skew {
+
+struct Shape {
+    virtual ~Shape() {
+    }
+};
+
+template<int N>
+struct Leaf : Shape {};
+
+constexpr int leaves = 128, hot_stride = 16, calls = 64;
+
+struct scattered : default_policy::rebind<scattered> {};
+
+struct profiled : default_policy::rebind<profiled>::add<
+                      basic_call_profile<profiled>> {};
+
+template<class Policy>
+struct perimeter_;
+
+template<class Policy>
+using perimeter =
+    method<perimeter_<Policy>, int(virtual_ptr<Shape, Policy>), Policy>;
+
+template<class Policy>
+struct area_;
+
+template<class Policy>
+using area = method<area_<Policy>, int(virtual_ptr<Shape, Policy>), Policy>;
+
+template<class Policy, int N>
+int leaf_perimeter(virtual_ptr<Leaf<N>, Policy>) {
+    return -N;
+}
+
+template<class Policy, int N>
+int leaf_area(virtual_ptr<Leaf<N>, Policy>) {
+    return N;
+}
+
+// The class of the object passed to each call.
+const std::vector<int>& draws() {
+    static std::vector<int> draws = []() {
+        std::vector<int> draws;
+        std::mt19937 rnd;
+
+        for (int i = 0; i < calls; ++i) {
+            if (rnd() % 10 < 8) {
+                draws.push_back(rnd() % (leaves / hot_stride) * hot_stride);
+            } else {
+                draws.push_back(rnd() % leaves);
+            }
+        }
+
+        return draws;
+    }();
+
+    return draws;
+}
+
+template<class Policy>
+std::vector<virtual_ptr<Shape, Policy>> population;
+
+template<int N>
+Leaf<N> leaf;
+
+template<class Policy, int... N>
+void register_leaves(std::integer_sequence<int, N...>) {
+    static use_classes<Shape, Leaf<N>..., Policy> classes;
+    static typename perimeter<Policy>::template add_functions<
+        leaf_perimeter<Policy, N>...>
+        perimeters;
+    static typename area<Policy>::template add_functions<
+        leaf_area<Policy, N>...>
+        areas;
+
+    updates.push_back([]() {
+        if constexpr (has_facet<Policy, call_profile>) {
+            // The profile that a training run on the same population would
+            // record with 'basic_call_counter'.
+            type_id types[] = {Policy::template static_type<Leaf<N>>()...};
+            std::map<int, std::size_t> counts;
+
+            for (auto draw : draws()) {
+                ++counts[draw];
+            }
+
+            std::stringstream profile;
+
+            for (auto [index, calls] : counts) {
+                Policy::type_name(
+                    Policy::template static_type<area<Policy>>(), profile);
+                profile << '\t';
+                Policy::type_name(types[index], profile);
+                profile << '\t' << calls << '\n';
+            }
+
+            Policy::read_profile(profile);
+        }
+
+        update<Policy>();
+
+        Shape* shapes[] = {&leaf<N>...};
+
+        for (auto draw : draws()) {
+            population<Policy>.emplace_back(*shapes[draw]);
+        }
+    });
+}
+
+template<class Policy>
+struct use_leaves {
+    use_leaves() {
+        register_leaves<Policy>(std::make_integer_sequence<int, leaves>());
+    }
+};
+
+YOMM2_STATIC(use_leaves<scattered>);
+YOMM2_STATIC(use_leaves<profiled>);
+
+template<class Policy>
+__attribute__((noinline)) int call_skewed() {
+    int sum = 0;
+
+    for (auto& arg : population<Policy>) {
+        sum += area<Policy>::fn(arg);
+    }
+
+    return sum;
+}
+
+volatile int sink;
+
+BENCHMARK(skew, sink = call_skewed<scattered>());
+BENCHMARK(skew_pgo, sink = call_skewed<profiled>());
+
+} // namespace skew
+
 // -----------------------------------------------------------------------------
 // driver
 
@@ -309,6 +478,10 @@ __attribute__((noinline)) void flush_cache() {
 }
 
 int main(int argc, char** argv) {
+    for (auto update : updates) {
+        update();
+    }
+
     dyn::Cat dyn_ref;
     auto dyn_vp = virtual_ptr(dyn_ref);
     stat::Cat stat_ref;
@@ -148,6 +148,40 @@ struct std_map_policy : virtual_by_reference {
     };
 };
 
+struct narrow_dispatch_policy : virtual_by_reference {
+    struct policy : default_static::rebind<policy>::add<
+                        yomm2::policy::basic_narrow_dispatch<policy>> {};
+    template<typename Inheritance>
+    using base_type = orthogonal_base<Inheritance>;
+    static std::string name() {
+        return "narrow_dispatch_policy";
+    };
+};
+
+struct sparse_dispatch_policy : virtual_by_reference {
+    // compress all the tables, to measure the cost of the lookup
+    struct policy : default_static::rebind<policy>::add<
+                        yomm2::policy::basic_sparse_dispatch<policy, 0>> {};
+    template<typename Inheritance>
+    using base_type = orthogonal_base<Inheritance>;
+    static std::string name() {
+        return "sparse_dispatch_policy";
+    };
+};
+
+#if defined(__GXX_ABI_VERSION)
+struct vtable_vptr_policy : virtual_by_reference {
+    struct policy : default_static::rebind<policy>::replace<
+                        yomm2::policy::external_vptr,
+                        yomm2::policy::vtable_vptr<policy>> {};
+    template<typename Inheritance>
+    using base_type = orthogonal_base<Inheritance>;
+    static std::string name() {
+        return "vtable_vptr_policy";
+    };
+};
+#endif
+
 #if UNORDERED_FLAT_MAP_AVAILABLE
 struct flat_map_policy : virtual_by_reference {
     struct policy : default_static::rebind<policy>::
@@ -216,13 +250,32 @@ struct indirect_virtual_ptr_dispatch {
     };
 };
 
+struct compact_virtual_ptr_dispatch {
+    template<class Population>
+    static auto draw(Population& pop) {
+        return pop.cvptr_draw();
+    }
+    struct policy : default_static::rebind<policy>,
+                    yomm2::policy::compact_vptr {};
+    template<typename Inheritance>
+    using base_type = orthogonal_base<Inheritance>;
+    static std::string name() {
+        return "compact_virtual_ptr";
+    };
+};
+
 using method_dispatch_types = std::tuple<
-    use_basic_policy, std_map_policy,
+    use_basic_policy, std_map_policy, narrow_dispatch_policy,
+    sparse_dispatch_policy,
+#if defined(__GXX_ABI_VERSION)
+    vtable_vptr_policy,
+#endif
 #if UNORDERED_FLAT_MAP_AVAILABLE
     flat_map_policy,
 #endif
     direct_virtual_ptr_dispatch, indirect_virtual_ptr_dispatch,
-    direct_intrusive_dispatch, indirect_intrusive_dispatch>;
+    compact_virtual_ptr_dispatch, direct_intrusive_dispatch,
+    indirect_intrusive_dispatch>;
 
 using dispatch_types = mp_append<
     std::tuple<no_dispatch, virtual_dispatch, direct_virtual_ptr_dispatch>,
@@ -504,6 +557,8 @@ struct population : abstract_population {
     std::vector<virtual_ptr<base, direct_virtual_ptr_dispatch::policy>> vptrs;
     std::vector<virtual_ptr<base, indirect_virtual_ptr_dispatch::policy>>
         ivptrs;
+    std::vector<virtual_ptr<base, compact_virtual_ptr_dispatch::policy>>
+        cvptrs;
 
     static population instance;
 
@@ -550,6 +605,7 @@ struct population : abstract_population {
         objects.push_back(obj);
         vptrs.emplace_back(*obj);
         ivptrs.emplace_back(*obj);
+        cvptrs.emplace_back(*obj);
 
         return obj;
     }
@@ -565,6 +621,10 @@ struct population : abstract_population {
     auto ivptr_draw() {
         return ivptrs[dist(rnd)];
     }
+
+    auto cvptr_draw() {
+        return cvptrs[dist(rnd)];
+    }
 };
 
 template<typename N>
@@ -594,6 +654,157 @@ struct Benchmark {
     }
 };
 
+template<typename Dispatch, typename Inheritance, typename Batch>
+struct ForEachBenchmark {
+    using population_type = population<std::integral_constant<std::size_t, 0>>;
+    using method_type = typename population_type::template methods<
+        Dispatch, Inheritance>::method1;
+    using base_type = typename Dispatch::template base_type<Inheritance>;
+
+    std::string name;
+
+    ForEachBenchmark() {
+        name = Dispatch::name() + (Batch::value ? "-for_each-" : "-loop-") +
+            Inheritance::name();
+        benchmark::RegisterBenchmark(name.c_str(), run);
+    }
+
+    static void run(benchmark::State& state) {
+        std::vector<std::reference_wrapper<base_type>> objects;
+
+        for (auto obj : population_type::instance.objects) {
+            objects.push_back(*obj);
+        }
+
+        for (auto _ : state) {
+            if constexpr (Batch::value) {
+                method_type::fn.for_each(objects);
+            } else {
+                for (base_type& obj : objects) {
+                    method_type::fn(obj);
+                }
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * objects.size());
+    }
+};
+
+template<typename Dispatch, typename Inheritance, typename Batch>
+struct ApplyGroupedBenchmark {
+    using population_type = population<std::integral_constant<std::size_t, 0>>;
+    using method_type = typename population_type::template methods<
+        Dispatch, Inheritance>::method2;
+    using base_type = typename Dispatch::template base_type<Inheritance>;
+
+    std::string name;
+
+    ApplyGroupedBenchmark() {
+        name = Dispatch::name() +
+            (Batch::value ? "-apply_grouped-" : "-pair_loop-") +
+            Inheritance::name();
+        benchmark::RegisterBenchmark(name.c_str(), run);
+    }
+
+    static void run(benchmark::State& state) {
+        auto& objects = population_type::instance.objects;
+        std::vector<std::tuple<base_type&, base_type&>> pairs;
+
+        for (std::size_t i = 0; i + 1 < objects.size(); ++i) {
+            pairs.emplace_back(*objects[i], *objects[i + 1]);
+        }
+
+        for (auto _ : state) {
+            if constexpr (Batch::value) {
+                method_type::fn.apply_grouped(pairs);
+            } else {
+                for (auto& pair : pairs) {
+                    method_type::fn(std::get<0>(pair), std::get<1>(pair));
+                }
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * pairs.size());
+    }
+};
+
+template<
+    typename Dispatch, typename Inheritance, typename Degree, typename Cached>
+struct InlineCacheBenchmark {
+    using population_type = population<std::integral_constant<std::size_t, 0>>;
+    using method_type = typename population_type::template methods<
+        Dispatch, Inheritance>::method1;
+    using base_type = typename Dispatch::template base_type<Inheritance>;
+
+    std::string name;
+
+    InlineCacheBenchmark() {
+        name = Dispatch::name() +
+            (Cached::value ? "-inline_cache-" : "-call-") +
+            std::to_string(Degree::value) + "_classes-" + Inheritance::name();
+        benchmark::RegisterBenchmark(name.c_str(), run);
+    }
+
+    static void run(benchmark::State& state) {
+        auto& instance = population_type::instance;
+        std::vector<std::reference_wrapper<base_type>> objects;
+
+        // objects are allocated round-robin from the leaf classes
+        for (std::size_t i = 0; i < instance.objects.size(); ++i) {
+            if (i % instance.factories.size() < Degree::value) {
+                objects.push_back(*instance.objects[i]);
+            }
+        }
+
+        typename method_type::template inline_cache<> cache;
+
+        for (auto _ : state) {
+            for (base_type& obj : objects) {
+                if constexpr (Cached::value) {
+                    cache(obj);
+                } else {
+                    method_type::fn(obj);
+                }
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * objects.size());
+    }
+};
+
+template<typename Dispatch, typename Inheritance>
+struct VirtualPtrScanBenchmark {
+    using population_type = population<std::integral_constant<std::size_t, 0>>;
+    using methods_type =
+        typename population_type::template methods<Dispatch, Inheritance>;
+    using method_type = typename methods_type::method1;
+    using vptr_type = typename methods_type::varg_type;
+
+    std::string name;
+
+    VirtualPtrScanBenchmark() {
+        name = Dispatch::name() + "-scan-" + Inheritance::name();
+        benchmark::RegisterBenchmark(name.c_str(), run);
+    }
+
+    static void run(benchmark::State& state) {
+        std::vector<vptr_type> ptrs;
+
+        for (auto obj : population_type::instance.objects) {
+            ptrs.emplace_back(*obj);
+        }
+
+        for (auto _ : state) {
+            for (auto& ptr : ptrs) {
+                method_type::fn(ptr);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * ptrs.size());
+        state.counters["bytes_per_ptr"] = sizeof(vptr_type);
+    }
+};
+
 int main(int argc, char** argv) {
     std::ostringstream version;
 #if defined(__clang__)
@@ -630,6 +841,42 @@ int main(int argc, char** argv) {
             arity_types, inheritance_types>>
         YOMM2_GENSYM;
 
+    mp_apply<
+        std::tuple,
+        apply_product<
+            templates<ForEachBenchmark>,
+            std::tuple<use_basic_policy, direct_intrusive_dispatch>,
+            inheritance_types,
+            std::tuple<std::false_type, std::true_type>>>
+        YOMM2_GENSYM;
+
+    mp_apply<
+        std::tuple,
+        apply_product<
+            templates<ApplyGroupedBenchmark>,
+            std::tuple<use_basic_policy, direct_intrusive_dispatch>,
+            inheritance_types,
+            std::tuple<std::false_type, std::true_type>>>
+        YOMM2_GENSYM;
+
+    mp_apply<
+        std::tuple,
+        apply_product<
+            templates<InlineCacheBenchmark>, std::tuple<use_basic_policy>,
+            inheritance_types,
+            std::tuple<mp_size_t<1>, mp_size_t<3>, mp_size_t<10>>,
+            std::tuple<std::false_type, std::true_type>>>
+        YOMM2_GENSYM;
+
+    mp_apply<
+        std::tuple,
+        apply_product<
+            templates<VirtualPtrScanBenchmark>,
+            std::tuple<
+                direct_virtual_ptr_dispatch, compact_virtual_ptr_dispatch>,
+            inheritance_types>>
+        YOMM2_GENSYM;
+
     mp_for_each<method_dispatch_types>(
         [](auto value) { update<typename decltype(value)::policy>(); });
 
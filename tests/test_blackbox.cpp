@@ -4,6 +4,9 @@
 // or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
 #include <stdexcept>
 #include <type_traits>
 
@@ -462,3 +465,1214 @@ BOOST_AUTO_TEST_CASE(update_report) {
 }
 
 } // namespace report
+
+namespace batch {
+
+using test_policy = test_policy_<__COUNTER__>;
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, test_policy);
+
+struct name_;
+using name = method<
+    name_, void(virtual_<const Animal&>, std::string&), test_policy>;
+
+void name_dog(const Dog&, std::string& out) {
+    out += "d";
+}
+
+void name_cat(const Cat&, std::string& out) {
+    out += "c";
+}
+
+YOMM2_STATIC(name::add_function<name_dog>);
+YOMM2_STATIC(name::add_function<name_cat>);
+
+BOOST_AUTO_TEST_CASE(for_each) {
+    update<test_policy>();
+
+    Dog dog;
+    Cat cat;
+    std::vector<std::reference_wrapper<const Animal>> animals;
+    std::string expected;
+
+    // more than one batch, last one incomplete
+    for (std::size_t i = 0; i < 2 * name::batch_size + 3; ++i) {
+        if (i % 3) {
+            animals.push_back(dog);
+            expected += "d";
+        } else {
+            animals.push_back(cat);
+            expected += "c";
+        }
+    }
+
+    std::string out;
+    name::fn.for_each(animals, out);
+    BOOST_TEST(out == expected);
+
+    out.clear();
+    name::fn.for_each(std::vector<std::reference_wrapper<const Animal>>(), out);
+    BOOST_TEST(out.empty());
+}
+
+
+struct meet_;
+using meet = method<
+    meet_,
+    void(virtual_<const Animal&>, virtual_<const Animal&>, std::string&),
+    test_policy>;
+
+void meet_dog_dog(const Dog&, const Dog&, std::string& out) {
+    out += "dd";
+}
+
+void meet_dog_cat(const Dog&, const Cat&, std::string& out) {
+    out += "dc";
+}
+
+void meet_cat_animal(const Cat&, const Animal&, std::string& out) {
+    out += "ca";
+}
+
+YOMM2_STATIC(meet::add_function<meet_dog_dog>);
+YOMM2_STATIC(meet::add_function<meet_dog_cat>);
+YOMM2_STATIC(meet::add_function<meet_cat_animal>);
+
+BOOST_AUTO_TEST_CASE(apply_grouped) {
+    update<test_policy>();
+
+    Dog dog;
+    Cat cat;
+    std::string out;
+    using args = std::tuple<const Animal&, const Animal&, std::string&>;
+
+    std::vector<args> calls = {
+        {dog, cat, out}, {cat, dog, out}, {dog, dog, out}, {dog, cat, out},
+        {cat, cat, out}, {dog, dog, out}, {dog, cat, out},
+    };
+
+    meet::fn.apply_grouped(calls);
+
+    // each call made once, calls to the same definition are contiguous
+    BOOST_TEST(out.size() == 2 * calls.size());
+    std::vector<std::string> runs;
+
+    for (std::size_t i = 0; i < out.size(); i += 2) {
+        auto call = out.substr(i, 2);
+
+        if (runs.empty() || runs.back() != call) {
+            BOOST_TEST(std::count(runs.begin(), runs.end(), call) == 0);
+            runs.push_back(call);
+        }
+    }
+
+    BOOST_TEST(runs.size() == 3);
+    BOOST_TEST(std::count(out.begin(), out.end(), 'a') == 2);
+    BOOST_TEST(out.find("dcdcdc") != std::string::npos);
+    BOOST_TEST(out.find("dddd") != std::string::npos);
+}
+
+} // namespace batch
+
+namespace inline_cache {
+
+using test_policy = test_policy_<__COUNTER__>;
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+struct Bird : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, Bird, test_policy);
+
+struct name_;
+using name = method<name_, std::string(virtual_<const Animal&>), test_policy>;
+
+std::string name_animal(const Animal&) {
+    return "animal";
+}
+
+std::string name_cat(const Cat&) {
+    return "cat";
+}
+
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+YOMM2_STATIC(name::add_function<name_animal>);
+YOMM2_STATIC(name::add_function<name_cat>);
+
+BOOST_AUTO_TEST_CASE(test_inline_cache) {
+    update<test_policy>();
+
+    Dog dog;
+    Cat cat;
+    Bird bird;
+
+    name::inline_cache<2> cache;
+
+    for (int i = 0; i < 2; ++i) {
+        BOOST_TEST(cache(dog) == "animal");
+        BOOST_TEST(cache(cat) == "cat");
+        // evicts dog
+        BOOST_TEST(cache(bird) == "animal");
+    }
+
+    // invalidated by update
+    YOMM2_STATIC(name::add_function<name_dog>);
+    update<test_policy>();
+    BOOST_TEST(cache(dog) == "dog");
+    BOOST_TEST(cache(cat) == "cat");
+    BOOST_TEST(cache(bird) == "animal");
+}
+
+} // namespace inline_cache
+
+#if defined(__GXX_ABI_VERSION)
+
+namespace vtable_vptr {
+
+struct test_policy : test_policy_<__COUNTER__>::rebind<test_policy>::replace<
+                         policy::external_vptr,
+                         policy::vtable_vptr<test_policy>> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Pet {
+    virtual ~Pet() {
+    }
+};
+
+// 'Pet' is not a primary base, thus has its own v-table
+struct Dog : Animal, Pet {};
+struct Cat : Animal, Pet {};
+
+YOMM2_CLASSES(Animal, Pet, Dog, Cat, test_policy);
+
+struct name_;
+using name = method<name_, std::string(virtual_<const Animal&>), test_policy>;
+
+struct owner_;
+using owner = method<owner_, std::string(virtual_<const Pet&>), test_policy>;
+
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+std::string name_cat(const Cat&) {
+    return "cat";
+}
+
+std::string owner_dog(const Dog&) {
+    return "Charlie";
+}
+
+std::string owner_cat(const Cat&) {
+    return "Jon";
+}
+
+YOMM2_STATIC(name::add_function<name_dog>);
+YOMM2_STATIC(name::add_function<name_cat>);
+YOMM2_STATIC(owner::add_function<owner_dog>);
+YOMM2_STATIC(owner::add_function<owner_cat>);
+
+BOOST_AUTO_TEST_CASE(test_vtable_vptr) {
+    update<test_policy>();
+
+    Dog dog;
+    Cat cat;
+
+    for (int i = 0; i < 2; ++i) {
+        BOOST_TEST(name::fn(dog) == "dog");
+        BOOST_TEST(name::fn(cat) == "cat");
+        BOOST_TEST(owner::fn(dog) == "Charlie");
+        BOOST_TEST(owner::fn(cat) == "Jon");
+    }
+
+    BOOST_TEST(
+        test_policy::dynamic_vptr<Animal>(dog) ==
+        test_policy::dynamic_vptr<Pet>(dog));
+
+    // the cache is cleared by update
+    update<test_policy>();
+    BOOST_TEST(name::fn(dog) == "dog");
+    BOOST_TEST(owner::fn(cat) == "Jon");
+}
+
+} // namespace vtable_vptr
+
+#endif
+
+namespace cached_casts {
+
+using test_policy = test_policy_<__COUNTER__>;
+
+struct Animal {
+    virtual ~Animal() {
+    }
+
+    int age = 0;
+};
+
+struct Mammal : virtual Animal {
+    int legs = 4;
+};
+
+struct Dog : Mammal {};
+
+struct Pack {
+    virtual ~Pack() {
+    }
+
+    int size = 0;
+};
+
+// the Animal to Mammal offset is not the same in a Dog and in a Wolf
+struct Wolf : Pack, Dog {};
+
+YOMM2_CLASSES(Animal, Mammal, Dog, Pack, Wolf, test_policy);
+
+struct address_;
+using address =
+    method<address_, const void*(virtual_<Animal&>), test_policy>;
+
+const void* address_mammal(Mammal& mammal) {
+    return &mammal;
+}
+
+YOMM2_STATIC(address::add_function<address_mammal>);
+
+BOOST_AUTO_TEST_CASE(test_cached_casts) {
+    update<test_policy>();
+
+    Dog dog;
+    Wolf wolf;
+    Mammal mammal;
+
+    for (int i = 0; i < 2; ++i) {
+        BOOST_TEST(address::fn(dog) == static_cast<Mammal*>(&dog));
+        BOOST_TEST(address::fn(wolf) == static_cast<Mammal*>(&wolf));
+        BOOST_TEST(address::fn(mammal) == &mammal);
+    }
+}
+
+} // namespace cached_casts
+
+namespace bound_call {
+
+using test_policy = test_policy_<__COUNTER__>;
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, test_policy);
+
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<const Animal&>, virtual_<const Animal&>, int),
+    test_policy>;
+
+std::string meet_animals(const Animal&, const Animal&, int n) {
+    return "ignore " + std::to_string(n);
+}
+
+std::string meet_dog_cat(const Dog&, const Cat&, int n) {
+    return "chase " + std::to_string(n);
+}
+
+YOMM2_STATIC(meet::add_function<meet_animals>);
+
+BOOST_AUTO_TEST_CASE(test_bound_call) {
+    update<test_policy>();
+
+    Dog dog;
+    Cat cat;
+
+    meet::bound_call call(dog, cat, 0);
+    BOOST_TEST(call.is_current());
+    BOOST_TEST(call.function() == meet::fn.resolve(dog, cat, 0));
+    BOOST_TEST(call(dog, cat, 1) == "ignore 1");
+    BOOST_TEST(call(dog, cat, 2) == "ignore 2");
+
+    // resolved again after update
+    YOMM2_STATIC(meet::add_function<meet_dog_cat>);
+    update<test_policy>();
+    BOOST_TEST(!call.is_current());
+    BOOST_TEST(call(dog, cat, 3) == "chase 3");
+    BOOST_TEST(call.is_current());
+}
+
+} // namespace bound_call
+
+namespace narrow_dispatch {
+
+struct test_policy
+    : test_policy_<__COUNTER__>::rebind<test_policy>::add<
+          policy::basic_narrow_dispatch<test_policy>> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+struct Bird : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, Bird, test_policy);
+
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<const Animal&>, virtual_<const Animal&>),
+    test_policy>;
+
+std::string meet_animals(const Animal&, const Animal&) {
+    return "ignore";
+}
+
+std::string meet_dog_cat(const Dog&, const Cat&) {
+    return "chase";
+}
+
+std::string meet_cat_bird(const Cat&, const Bird&) {
+    return "hunt";
+}
+
+YOMM2_STATIC(meet::add_function<meet_animals>);
+YOMM2_STATIC(meet::add_function<meet_dog_cat>);
+YOMM2_STATIC(meet::add_function<meet_cat_bird>);
+
+BOOST_AUTO_TEST_CASE(test_narrow_dispatch) {
+    auto report = update<test_policy>().report;
+
+    // 3 x 3 groups: Animal, Dog and Cat as first argument, Animal, Cat and
+    // Bird as second argument; 3 definitions
+    BOOST_TEST(test_policy::cell_data.size() == 9u);
+    BOOST_TEST(
+        report.dispatch_bytes_saved ==
+        std::ptrdiff_t(
+            9 * (sizeof(std::uintptr_t) - sizeof(std::uint16_t)) -
+            3 * sizeof(std::uintptr_t)));
+
+    Dog dog;
+    Cat cat;
+    Bird bird;
+
+    BOOST_TEST(meet::fn(dog, cat) == "chase");
+    BOOST_TEST(meet::fn(cat, bird) == "hunt");
+    BOOST_TEST(meet::fn(cat, dog) == "ignore");
+    BOOST_TEST(meet::fn(bird, bird) == "ignore");
+}
+
+} // namespace narrow_dispatch
+
+namespace sparse_dispatch {
+
+// compress all the tables, if it makes them smaller
+struct test_policy
+    : test_policy_<__COUNTER__>::rebind<test_policy>::add<
+          policy::basic_sparse_dispatch<test_policy, 0>> {};
+
+struct A {
+    virtual ~A() {
+    }
+};
+
+template<int N>
+struct B : A {};
+
+using B1 = B<1>;
+using B2 = B<2>;
+using B3 = B<3>;
+using B4 = B<4>;
+using B5 = B<5>;
+
+YOMM2_CLASSES(A, B1, B2, B3, B4, B5, test_policy);
+
+struct match_;
+using match =
+    method<match_, int(virtual_<const A&>, virtual_<const A&>), test_policy>;
+
+int match_any(const A&, const A&) {
+    return 0;
+}
+
+template<int N>
+int match_same(const B<N>&, const B<N>&) {
+    return N;
+}
+
+YOMM2_STATIC(match::add_function<match_any>);
+YOMM2_STATIC(match::add_function<match_same<1>>);
+YOMM2_STATIC(match::add_function<match_same<2>>);
+YOMM2_STATIC(match::add_function<match_same<3>>);
+YOMM2_STATIC(match::add_function<match_same<4>>);
+YOMM2_STATIC(match::add_function<match_same<5>>);
+
+struct triple_;
+using triple = method<
+    triple_,
+    int(virtual_<const A&>, virtual_<const A&>, virtual_<const A&>),
+    test_policy>;
+
+int triple_any(const A&, const A&, const A&) {
+    return 0;
+}
+
+int triple_1(const B1&, const A&, const B2&) {
+    return 1;
+}
+
+int triple_2(const A&, const B2&, const B3&) {
+    return 2;
+}
+
+int triple_3(const B3&, const B3&, const B4&) {
+    return 3;
+}
+
+int triple_4(const B4&, const A&, const B5&) {
+    return 4;
+}
+
+int triple_5(const B5&, const B5&, const B1&) {
+    return 5;
+}
+
+YOMM2_STATIC(triple::add_function<triple_any>);
+YOMM2_STATIC(triple::add_function<triple_1>);
+YOMM2_STATIC(triple::add_function<triple_2>);
+YOMM2_STATIC(triple::add_function<triple_3>);
+YOMM2_STATIC(triple::add_function<triple_4>);
+YOMM2_STATIC(triple::add_function<triple_5>);
+
+BOOST_AUTO_TEST_CASE(test_sparse_dispatch) {
+    auto report = update<test_policy>().report;
+    BOOST_TEST(report.sparse_tables == 2u);
+
+    A a;
+    B1 b1;
+    B2 b2;
+    B3 b3;
+    B4 b4;
+    B5 b5;
+    const A* objects[] = {&a, &b1, &b2, &b3, &b4, &b5};
+
+    // index of the definition for each virtual argument, 0 = any
+    int triples[][3] = {{1, 0, 2}, {0, 2, 3}, {3, 3, 4}, {4, 0, 5}, {5, 5, 1}};
+
+    for (int x = 0; x < 6; ++x) {
+        for (int y = 0; y < 6; ++y) {
+            BOOST_TEST(
+                match::fn(*objects[x], *objects[y]) == (x == y ? x : 0));
+
+            for (int z = 0; z < 6; ++z) {
+                int expected = 0;
+
+                for (int i = 0; i < 5; ++i) {
+                    auto& t = triples[i];
+
+                    if ((t[0] == 0 || t[0] == x) && (t[1] == 0 || t[1] == y) &&
+                        t[2] == z) {
+                        expected = i + 1;
+                    }
+                }
+
+                BOOST_TEST(
+                    triple::fn(*objects[x], *objects[y], *objects[z]) ==
+                    expected);
+            }
+        }
+    }
+}
+
+} // namespace sparse_dispatch
+
+namespace shared_tables {
+
+using test_policy = test_policy_<__COUNTER__>;
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+struct Bird : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, Bird, test_policy);
+
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<const Animal&>, virtual_<const Animal&>),
+    test_policy>;
+
+struct greet_;
+using greet = method<
+    greet_, std::string(virtual_<const Animal&>, virtual_<const Animal&>),
+    test_policy>;
+
+std::string ignore(const Animal&, const Animal&) {
+    return "ignore";
+}
+
+std::string chase(const Dog&, const Cat&) {
+    return "chase";
+}
+
+// same functions, thus same thunks
+YOMM2_STATIC(meet::add_function<ignore>);
+YOMM2_STATIC(meet::add_function<chase>);
+YOMM2_STATIC(greet::add_function<ignore>);
+YOMM2_STATIC(greet::add_function<chase>);
+
+BOOST_AUTO_TEST_CASE(test_shared_tables) {
+    auto report = update<test_policy>().report;
+
+    // 2 x 2 groups: Dog and the others as first argument, Cat and the others
+    // as second argument
+    BOOST_TEST(report.shared_cells == 4u);
+    // Bird is in the same groups as Animal, for both methods
+    BOOST_TEST(report.shared_vtbl_entries == 4u);
+    BOOST_TEST(
+        test_policy::static_vptr<Bird> == test_policy::static_vptr<Animal>);
+
+    Dog dog;
+    Cat cat;
+    Bird bird;
+
+    BOOST_TEST(meet::fn(dog, cat) == "chase");
+    BOOST_TEST(greet::fn(dog, cat) == "chase");
+    BOOST_TEST(meet::fn(cat, dog) == "ignore");
+    BOOST_TEST(greet::fn(bird, cat) == "ignore");
+    BOOST_TEST(greet::fn(dog, bird) == "ignore");
+}
+
+} // namespace shared_tables
+
+namespace dispatch_image {
+
+struct test_policy : test_policy_<__COUNTER__>::rebind<test_policy>::replace<
+                         policy::external_vptr,
+                         policy::basic_dispatch_image<test_policy, 256>> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, test_policy);
+
+struct kick_;
+using kick =
+    method<kick_, std::string(virtual_<const Animal&>), test_policy>;
+
+std::string kick_dog(const Dog&) {
+    return "bark";
+}
+
+std::string kick_cat(const Cat&) {
+    return "hiss";
+}
+
+YOMM2_STATIC(kick::add_function<kick_dog>);
+YOMM2_STATIC(kick::add_function<kick_cat>);
+
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<const Animal&>, virtual_<const Animal&>),
+    test_policy>;
+
+std::string meet_animals(const Animal&, const Animal&) {
+    return "ignore";
+}
+
+std::string meet_dog_cat(const Dog&, const Cat&) {
+    return "chase";
+}
+
+YOMM2_STATIC(meet::add_function<meet_animals>);
+YOMM2_STATIC(meet::add_function<meet_dog_cat>);
+
+BOOST_AUTO_TEST_CASE(test_dispatch_image) {
+    update<test_policy>();
+
+    auto first = test_policy::image;
+    auto last = first + test_policy::image_size;
+
+    BOOST_TEST(std::uintptr_t(first) % 64 == 0u);
+
+    for (auto vptr :
+         {test_policy::static_vptr<Animal>, test_policy::static_vptr<Dog>,
+          test_policy::static_vptr<Cat>}) {
+        BOOST_TEST((vptr >= first && vptr < last));
+    }
+
+    Dog dog;
+    Cat cat;
+
+    BOOST_TEST(kick::fn(dog) == "bark");
+    BOOST_TEST(kick::fn(cat) == "hiss");
+    BOOST_TEST(meet::fn(dog, cat) == "chase");
+    BOOST_TEST(meet::fn(cat, dog) == "ignore");
+    BOOST_TEST(
+        (test_policy::dynamic_vptr<Animal>(dog) ==
+         test_policy::static_vptr<Dog>));
+}
+
+} // namespace dispatch_image
+
+namespace cache_aligned_dispatch {
+
+struct test_policy
+    : test_policy_<__COUNTER__>::rebind<test_policy>::add<
+          policy::basic_cache_aligned_dispatch<test_policy>> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+struct Bird : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, Bird, test_policy);
+
+template<int N>
+struct name_;
+
+template<int N>
+using name =
+    method<name_<N>, std::string(virtual_<const Animal&>), test_policy>;
+
+template<int N>
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+template<int N>
+std::string name_cat(const Cat&) {
+    return "cat";
+}
+
+YOMM2_STATIC(name<0>::add_function<name_dog<0>>);
+YOMM2_STATIC(name<1>::add_function<name_cat<1>>);
+YOMM2_STATIC(name<2>::add_function<name_dog<2>>);
+
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<const Animal&>, virtual_<const Animal&>),
+    test_policy>;
+
+std::string meet_animals(const Animal&, const Animal&) {
+    return "ignore";
+}
+
+std::string meet_dog_cat(const Dog&, const Cat&) {
+    return "chase";
+}
+
+YOMM2_STATIC(meet::add_function<meet_animals>);
+YOMM2_STATIC(meet::add_function<meet_dog_cat>);
+
+BOOST_AUTO_TEST_CASE(test_cache_aligned_dispatch) {
+    auto report = update<test_policy>().report;
+    BOOST_TEST(report.padding_words > 0u);
+
+    // 3 uni-methods + a multi-method with two virtual parameters: 5 slots,
+    // starting at slot 0, since all the methods are for 'Animal'
+    for (auto vtbl :
+         {test_policy::static_vptr<Animal>, test_policy::static_vptr<Dog>,
+          test_policy::static_vptr<Cat>, test_policy::static_vptr<Bird>}) {
+        auto offset = std::uintptr_t(vtbl) % 64 / sizeof(std::uintptr_t);
+        BOOST_TEST(offset + 5 <= 64 / sizeof(std::uintptr_t));
+    }
+
+    Dog dog;
+    Cat cat;
+    Bird bird;
+
+    BOOST_TEST(name<0>::fn(dog) == "dog");
+    BOOST_TEST(name<1>::fn(cat) == "cat");
+    BOOST_TEST(name<2>::fn(dog) == "dog");
+    BOOST_TEST(meet::fn(dog, cat) == "chase");
+    BOOST_TEST(meet::fn(bird, cat) == "ignore");
+}
+
+} // namespace cache_aligned_dispatch
+
+namespace call_profile {
+
+template<class Policy, class Type>
+std::string name_of() {
+    std::ostringstream os;
+    Policy::type_name(Policy::template static_type<Type>(), os);
+    return os.str();
+}
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+struct Bird : Animal {};
+
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+std::string name_cat(const Cat&) {
+    return "cat";
+}
+
+std::string name_bird(const Bird&) {
+    return "bird";
+}
+
+std::string meet_animals(const Animal&, const Animal&) {
+    return "ignore";
+}
+
+namespace counter {
+
+struct test_policy : test_policy_<__COUNTER__>::rebind<test_policy>::add<
+                         policy::basic_call_counter<test_policy>> {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, test_policy);
+
+struct name_;
+using name =
+    method<name_, std::string(virtual_<const Animal&>), test_policy>;
+YOMM2_STATIC(name::add_function<name_dog>);
+YOMM2_STATIC(name::add_function<name_cat>);
+
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<const Animal&>, virtual_<const Animal&>),
+    test_policy>;
+YOMM2_STATIC(meet::add_function<meet_animals>);
+
+BOOST_AUTO_TEST_CASE(test_call_counter) {
+    update<test_policy>();
+
+    Dog dog;
+    Cat cat;
+
+    for (int i = 0; i < 3; ++i) {
+        name::fn(dog);
+    }
+
+    name::fn(cat);
+    meet::fn(dog, cat);
+    meet::fn(dog, cat);
+
+    std::ostringstream os;
+    test_policy::write_profile(os);
+
+    std::map<std::pair<std::string, std::string>, std::size_t> expected = {
+        {{name_of<test_policy, name>(), name_of<test_policy, Dog>()}, 3},
+        {{name_of<test_policy, name>(), name_of<test_policy, Cat>()}, 1},
+        {{name_of<test_policy, meet>(), name_of<test_policy, Dog>()}, 2},
+        {{name_of<test_policy, meet>(), name_of<test_policy, Cat>()}, 2},
+    };
+
+    std::string profile;
+
+    for (auto& [key, calls] : expected) {
+        profile += key.first + '\t' + key.second + '\t' +
+            std::to_string(calls) + '\n';
+    }
+
+    BOOST_TEST(os.str() == profile);
+}
+
+} // namespace counter
+
+namespace profile {
+
+struct test_policy : test_policy_<__COUNTER__>::rebind<test_policy>::add<
+                         policy::basic_call_profile<test_policy>> {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, Bird, test_policy);
+
+template<int N>
+struct name_;
+
+template<int N>
+using name =
+    method<name_<N>, std::string(virtual_<const Animal&>), test_policy>;
+
+YOMM2_STATIC(name<0>::add_function<name_dog>);
+YOMM2_STATIC(name<1>::add_function<name_cat>);
+YOMM2_STATIC(name<2>::add_function<name_bird>);
+
+BOOST_AUTO_TEST_CASE(test_call_profile) {
+    {
+        std::istringstream is("name\tclass\tmany\n");
+        BOOST_TEST(!test_policy::read_profile(is));
+        test_policy::profile.clear();
+    }
+
+    std::istringstream is(
+        name_of<test_policy, name<2>>() + "\t" +
+        name_of<test_policy, Bird>() + "\t100\n" +
+        name_of<test_policy, name<0>>() + "\t" + name_of<test_policy, Dog>() +
+        "\t10\n\n" + "no_such_method\t" + name_of<test_policy, Dog>() +
+        "\t5\n");
+    BOOST_TEST(test_policy::read_profile(is));
+
+    auto report = update<test_policy>().report;
+    BOOST_TEST(report.profiled_calls == 110u);
+    BOOST_TEST(report.stale_profile_entries == 1u);
+
+    // The hottest method comes first in the v-tables...
+    BOOST_TEST(name<2>::fn.slots_strides[0] == 0u);
+    BOOST_TEST(name<0>::fn.slots_strides[0] == 1u);
+
+    // ...and the hottest classes come first in the dispatch data.
+    BOOST_TEST(
+        test_policy::static_vptr<Bird> < test_policy::static_vptr<Dog>);
+    BOOST_TEST(
+        test_policy::static_vptr<Dog> < test_policy::static_vptr<Animal>);
+    BOOST_TEST(
+        test_policy::static_vptr<Dog> < test_policy::static_vptr<Cat>);
+
+    Dog dog;
+    Cat cat;
+    Bird bird;
+
+    BOOST_TEST(name<0>::fn(dog) == "dog");
+    BOOST_TEST(name<1>::fn(cat) == "cat");
+    BOOST_TEST(name<2>::fn(bird) == "bird");
+}
+
+} // namespace profile
+
+} // namespace call_profile
+
+namespace static_guards {
+
+// 'debug' has runtime checks in all builds
+struct test_policy : policy::debug::rebind<test_policy>::replace<
+                         policy::error_handler, policy::throw_error> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, test_policy);
+
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+std::string name_cat(const Cat&) {
+    return "cat";
+}
+
+struct name_;
+using name =
+    method<name_, std::string(virtual_<const Animal&>), test_policy>;
+YOMM2_STATIC(name::add_function<name_dog>);
+YOMM2_STATIC(name::add_function<name_cat>);
+
+struct wrong_name_;
+using wrong_name =
+    method<wrong_name_, std::string(virtual_<const Animal&>), test_policy>;
+YOMM2_STATIC(wrong_name::add_function<name_dog>);
+YOMM2_STATIC(wrong_name::add_function<name_cat>);
+
+} // namespace static_guards
+
+// as written by 'generator::write_static_guards'
+template<>
+struct yorel::yomm2::detail::static_guard<static_guards::name> {
+    using type = static_guards::Dog;
+    static constexpr auto function = &static_guards::name_dog;
+};
+
+// does not match the dispatch tables
+template<>
+struct yorel::yomm2::detail::static_guard<static_guards::wrong_name> {
+    using type = static_guards::Dog;
+    static constexpr auto function = &static_guards::name_cat;
+};
+
+namespace static_guards {
+
+BOOST_AUTO_TEST_CASE(test_static_guards) {
+    update<test_policy>();
+
+    Dog dog;
+    Cat cat;
+
+    BOOST_TEST(name::fn(dog) == "dog");
+    BOOST_TEST(name::fn(cat) == "cat");
+    BOOST_TEST(wrong_name::fn(cat) == "cat");
+    BOOST_CHECK_THROW(wrong_name::fn(dog), static_guard_error);
+}
+
+} // namespace static_guards
+
+namespace dispatch_functions {
+
+struct test_policy
+    : policy::debug::rebind<test_policy>::replace<
+          policy::error_handler, policy::throw_error>::
+          add<policy::basic_dispatch_functions<test_policy>> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Puppy : Dog {};
+struct Cat : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Puppy, Cat, test_policy);
+
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+std::string name_cat(const Cat&) {
+    return "cat";
+}
+
+struct name_;
+using name =
+    method<name_, std::string(virtual_<const Animal&>), test_policy>;
+YOMM2_STATIC(name::add_function<name_dog>);
+YOMM2_STATIC(name::add_function<name_cat>);
+
+struct wrong_name_;
+using wrong_name =
+    method<wrong_name_, std::string(virtual_<const Animal&>), test_policy>;
+YOMM2_STATIC(wrong_name::add_function<name_dog>);
+YOMM2_STATIC(wrong_name::add_function<name_cat>);
+
+template<class Class>
+std::uintptr_t class_index() {
+    return test_policy::static_vptr<Class>[-1];
+}
+
+} // namespace dispatch_functions
+
+// 'generator::write_dispatch_functions' writes the indices as constants
+template<>
+struct yorel::yomm2::detail::dispatch_function<dispatch_functions::name> {
+    static constexpr std::size_t arity = 1;
+
+    template<class Call>
+    static decltype(auto)
+    dispatch(const std::uintptr_t* const* vptrs, Call call) {
+        using namespace dispatch_functions;
+
+        if (vptrs[0][-1] == class_index<Dog>()) {
+            return call(std::integral_constant<
+                        decltype(&name_dog), &name_dog>());
+        }
+
+        return call();
+    }
+};
+
+// does not match the dispatch tables
+template<>
+struct yorel::yomm2::detail::dispatch_function<
+    dispatch_functions::wrong_name> {
+    static constexpr std::size_t arity = 1;
+
+    template<class Call>
+    static decltype(auto)
+    dispatch(const std::uintptr_t* const* vptrs, Call call) {
+        using namespace dispatch_functions;
+
+        if (vptrs[0][-1] == class_index<Dog>()) {
+            return call(std::integral_constant<
+                        decltype(&name_cat), &name_cat>());
+        }
+
+        return call();
+    }
+};
+
+namespace dispatch_functions {
+
+BOOST_AUTO_TEST_CASE(test_dispatch_functions) {
+    auto report = update<test_policy>().report;
+
+    // Puppy shares Dog's v-table
+    BOOST_TEST(report.class_indices == 3u);
+    BOOST_TEST(class_index<Puppy>() == class_index<Dog>());
+    std::set<std::uintptr_t> indices{
+        class_index<Animal>(), class_index<Dog>(), class_index<Cat>()};
+    BOOST_TEST(indices.size() == 3u);
+    BOOST_TEST(*indices.rbegin() == 2u);
+
+    Dog dog;
+    Puppy puppy;
+    Cat cat;
+
+    BOOST_TEST(name::fn(dog) == "dog");
+    BOOST_TEST(name::fn(puppy) == "dog");
+    BOOST_TEST(name::fn(cat) == "cat");
+    BOOST_TEST(wrong_name::fn(cat) == "cat");
+    BOOST_CHECK_THROW(wrong_name::fn(dog), dispatch_function_error);
+}
+
+} // namespace dispatch_functions
+
+namespace dead_dimensions {
+
+struct test_policy : policy::release::rebind<test_policy> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Cat : Animal {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, test_policy);
+
+std::string meet_animals(Animal&, Animal&) {
+    return "ignore";
+}
+
+std::string meet_dog(Dog&, Animal&) {
+    return "wag";
+}
+
+// the second argument does not take part in the resolution
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<Animal&>, virtual_<Animal&>), test_policy>;
+YOMM2_STATIC(meet::add_function<meet_animals>);
+YOMM2_STATIC(meet::add_function<meet_dog>);
+
+// no argument takes part in the resolution
+struct greet_;
+using greet = method<
+    greet_, std::string(virtual_<Animal&>, virtual_<Animal&>), test_policy>;
+YOMM2_STATIC(greet::add_function<meet_animals>);
+
+std::string name_animal(Animal&) {
+    return "animal";
+}
+
+struct name_;
+using name = method<name_, std::string(virtual_<Animal&>), test_policy>;
+YOMM2_STATIC(name::add_function<name_animal>);
+
+BOOST_AUTO_TEST_CASE(test_dead_dimensions) {
+    auto report = update<test_policy>().report;
+
+    BOOST_TEST(report.dead_dimensions == 4u);
+    BOOST_TEST(report.direct_methods == 2u);
+
+    BOOST_TEST(meet::fn.slots_strides[3] == 0u);
+    BOOST_TEST(meet::fn.slots_strides[4] == 2u);
+    // the functions to call directly
+    BOOST_TEST(greet::fn.slots_strides[3] != 0u);
+    BOOST_TEST(name::fn.slots_strides[1] != 0u);
+
+    Dog dog;
+    Cat cat;
+
+    BOOST_TEST(meet::fn(dog, cat) == "wag");
+    BOOST_TEST(meet::fn(dog, dog) == "wag");
+    BOOST_TEST(meet::fn(cat, dog) == "ignore");
+    BOOST_TEST(greet::fn(dog, cat) == "ignore");
+    BOOST_TEST(name::fn(cat) == "animal");
+}
+
+} // namespace dead_dimensions
+
+namespace incremental_update {
+
+struct test_policy : policy::debug::rebind<test_policy> {};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Puppy : Dog {};
+
+YOMM2_CLASSES(Animal, Dog, test_policy);
+
+std::string name_animal(const Animal&) {
+    return "animal";
+}
+
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+struct name_;
+using name =
+    method<name_, std::string(virtual_<const Animal&>), test_policy>;
+YOMM2_STATIC(name::add_function<name_animal>);
+YOMM2_STATIC(name::add_function<name_dog>);
+
+BOOST_AUTO_TEST_CASE(test_incremental_update) {
+    BOOST_TEST(update<test_policy>().report.up_to_date == 0u);
+    auto epoch = test_policy::epoch;
+
+    BOOST_TEST(update<test_policy>().report.up_to_date == 1u);
+    BOOST_TEST(test_policy::epoch == epoch);
+    BOOST_TEST(name::fn(Dog()) == "dog");
+
+    {
+        // as if a library was loaded
+        use_classes<Dog, Puppy, test_policy> puppy_class;
+
+        BOOST_TEST(update<test_policy>().report.up_to_date == 0u);
+        BOOST_TEST(test_policy::epoch == epoch + 1);
+        BOOST_TEST(name::fn(Puppy()) == "dog");
+        BOOST_TEST(update<test_policy>().report.up_to_date == 1u);
+    }
+
+    // ...and unloaded
+    BOOST_TEST(update<test_policy>().report.up_to_date == 0u);
+    BOOST_TEST(name::fn(Dog()) == "dog");
+    BOOST_TEST(update<test_policy>().report.up_to_date == 1u);
+}
+
+} // namespace incremental_update
@@ -0,0 +1,139 @@
+// Copyright (c) 2018-2024 Jean-Louis Leroy
+// Distributed under the Boost Software License, Version 1.0.
+// See accompanying file LICENSE_1_0.txt
+// or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <yorel/yomm2/keywords.hpp>
+
+#define BOOST_TEST_MODULE yomm2
+#include <boost/test/included/unit_test.hpp>
+
+using namespace yorel::yomm2;
+
+// 'debug' checks that each vptr is looked up in the image that contains the
+// class; an image released too early, or a torn image, is likely to fail the
+// check.
+struct test_policy
+    : policy::debug::rebind<test_policy>::replace<
+          policy::external_vptr, policy::basic_concurrent_update<test_policy>> {
+};
+
+struct Animal {
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal {};
+struct Puppy : Dog {};
+struct Cat : Animal {};
+struct Kitten : Cat {};
+
+YOMM2_CLASSES(Animal, Dog, Cat, test_policy);
+
+std::string name_dog(const Dog&) {
+    return "dog";
+}
+
+std::string name_cat(const Cat&) {
+    return "cat";
+}
+
+struct name_;
+using name = method<name_, std::string(virtual_<const Animal&>), test_policy>;
+YOMM2_STATIC(name::add_function<name_dog>);
+YOMM2_STATIC(name::add_function<name_cat>);
+
+std::string meet_animals(const Animal&, const Animal&) {
+    return "ignore";
+}
+
+std::string meet_dog_cat(const Dog&, const Cat&) {
+    return "chase";
+}
+
+struct meet_;
+using meet = method<
+    meet_,
+    std::string(virtual_<const Animal&>, virtual_<const Animal&>),
+    test_policy>;
+YOMM2_STATIC(meet::add_function<meet_animals>);
+YOMM2_STATIC(meet::add_function<meet_dog_cat>);
+
+BOOST_AUTO_TEST_CASE(test_image_kept_while_pinned) {
+    update<test_policy>();
+    test_policy::release_images();
+    BOOST_TEST(test_policy::retired_images.empty());
+
+    {
+        // as if a method call was in progress
+        test_policy::read_guard guard;
+        auto image = test_policy::current_image.load();
+
+        use_classes<Dog, Puppy, test_policy> puppy_class;
+        update<test_policy>();
+
+        BOOST_TEST(test_policy::current_image.load() != image);
+        BOOST_TEST_REQUIRE(test_policy::retired_images.size() == 1u);
+        BOOST_TEST(test_policy::retired_images[0].second.get() == image);
+        BOOST_TEST(meet::fn(Dog(), Cat()) == "chase");
+    }
+
+    BOOST_TEST(name::fn(Puppy()) == "dog");
+    test_policy::release_images();
+    BOOST_TEST(test_policy::retired_images.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_update_while_dispatching) {
+    update<test_policy>();
+
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> calls{0}, errors{0};
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            Dog dog;
+            Cat cat;
+
+            while (!done.load()) {
+                if (name::fn(dog) != "dog" || name::fn(cat) != "cat" ||
+                    meet::fn(dog, cat) != "chase" ||
+                    meet::fn(cat, dog) != "ignore") {
+                    ++errors;
+                }
+
+                ++calls;
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        // Register classes, as if a library was loaded, to change the hash
+        // and the layout of the tables, then unregister them.
+        if (i % 2) {
+            use_classes<Dog, Puppy, test_policy> puppy_class;
+            update<test_policy>();
+        } else {
+            use_classes<Cat, Kitten, test_policy> kitten_class;
+            update<test_policy>();
+        }
+    }
+
+    update<test_policy>();
+    done = true;
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    BOOST_TEST(calls.load() > 0u);
+    BOOST_TEST(errors.load() == 0u);
+
+    test_policy::release_images();
+    BOOST_TEST(test_policy::retired_images.empty());
+}
@@ -2,6 +2,8 @@
 #include <boost/test/included/unit_test.hpp>
 #include <boost/utility/identity_type.hpp>
 
+#include <set>
+
 #include <yorel/yomm2/keywords.hpp>
 
 using namespace yorel::yomm2;
@@ -473,3 +475,206 @@ BOOST_AUTO_TEST_CASE(custom_rtti_deferred) {
 }
 
 } // namespace defered_type_id
+
+namespace dense_type_id {
+
+struct test_policy
+    : policy::default_static::rebind<test_policy>::replace<
+          policy::rtti, policy::dense_rtti<test_policy>>::
+          remove<policy::type_hash> {};
+
+struct Animal : with_type_id<Animal, test_policy> {
+    const char* name;
+
+    Animal(const char* name) : name(name) {
+    }
+
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal, with_type_id<Dog, Animal> {
+    using Animal::Animal;
+};
+
+struct Cat : Animal, with_type_id<Cat, Animal> {
+    using Animal::Animal;
+};
+
+register_classes(Animal, Dog, Cat, test_policy);
+
+declare_method(void, kick, (virtual_<Animal&>, std::ostream&), test_policy);
+
+define_method(void, kick, (Dog & dog, std::ostream& os)) {
+    os << dog.name << " barks.";
+}
+
+define_method(void, kick, (Cat & cat, std::ostream& os)) {
+    os << cat.name << " hisses.";
+}
+
+declare_method(
+    std::string, meet, (virtual_<Animal&>, virtual_<Animal&>), test_policy);
+
+define_method(std::string, meet, (Animal&, Animal&)) {
+    return "ignore";
+}
+
+define_method(std::string, meet, (Dog&, Cat&)) {
+    return "chase";
+}
+
+BOOST_AUTO_TEST_CASE(custom_rtti_dense) {
+    update<test_policy>();
+
+    auto animal_id = test_policy::static_type<Animal>();
+    auto dog_id = test_policy::static_type<Dog>();
+    auto cat_id = test_policy::static_type<Cat>();
+    std::set<type_id> ids{animal_id, dog_id, cat_id};
+    BOOST_TEST(ids.size() == 3u);
+    BOOST_TEST(*ids.rbegin() == 2u);
+    BOOST_TEST(test_policy::vptrs.size() == 3u);
+
+    Dog snoopy("Snoopy");
+    Cat sylvester("Sylvester");
+    Animal &a = snoopy, &b = sylvester;
+
+    BOOST_TEST(a.yomm2_type_id() == dog_id);
+    BOOST_TEST(b.yomm2_type_id() == cat_id);
+
+    {
+        std::stringstream os;
+        kick(a, os);
+        BOOST_TEST(os.str() == "Snoopy barks.");
+    }
+    {
+        std::stringstream os;
+        kick(b, os);
+        BOOST_TEST(os.str() == "Sylvester hisses.");
+    }
+
+    BOOST_TEST(meet(a, b) == "chase");
+    BOOST_TEST(meet(b, a) == "ignore");
+
+    // ids are resolved only once
+    update<test_policy>();
+    BOOST_TEST(test_policy::vptrs.size() == 3u);
+    BOOST_TEST(meet(a, b) == "chase");
+
+    virtual_ptr<Animal, test_policy> vptr(b);
+    BOOST_TEST(meet(a, *vptr) == "chase");
+}
+
+} // namespace dense_type_id
+
+namespace indexed_type_id {
+
+struct Animal;
+struct Dog;
+struct Cat;
+
+struct test_policy
+    : policy::debug::rebind<test_policy>::replace<
+          policy::rtti, policy::indexed_rtti<Animal, Dog, Cat>>::
+          remove<policy::type_hash>::replace<
+              policy::error_handler, policy::throw_error> {};
+
+struct Animal : with_type_id<Animal, test_policy> {
+    const char* name;
+
+    Animal(const char* name) : name(name) {
+    }
+
+    virtual ~Animal() {
+    }
+};
+
+struct Dog : Animal, with_type_id<Dog, Animal> {
+    using Animal::Animal;
+};
+
+struct Cat : Animal, with_type_id<Cat, Animal> {
+    using Animal::Animal;
+};
+
+static_assert(test_policy::static_type<Animal>() == 0);
+static_assert(test_policy::static_type<Dog>() == 1);
+static_assert(test_policy::static_type<Cat>() == 2);
+static_assert(test_policy::static_type<std::string>() == 3);
+
+register_classes(Animal, Dog, Cat, test_policy);
+
+struct kick_;
+using kick =
+    method<kick_, std::string(virtual_<Animal&>), test_policy>;
+
+std::string kick_dog(Dog& dog) {
+    return std::string(dog.name) + " barks.";
+}
+
+std::string kick_cat(Cat& cat) {
+    return std::string(cat.name) + " hisses.";
+}
+
+struct meet_;
+using meet = method<
+    meet_, std::string(virtual_<Animal&>, virtual_<Animal&>), test_policy>;
+
+std::string meet_animals(Animal&, Animal&) {
+    return "ignore";
+}
+
+std::string meet_dog_cat(Dog&, Cat&) {
+    return "chase";
+}
+
+std::string meet_dog_animal(Dog&, Animal&) {
+    return "sniff";
+}
+
+std::string meet_animal_cat(Animal&, Cat&) {
+    return "wait";
+}
+
+} // namespace indexed_type_id
+
+template<>
+struct yorel::yomm2::closed_definitions<indexed_type_id::kick> {
+    static constexpr auto functions =
+        std::make_tuple(&indexed_type_id::kick_dog, &indexed_type_id::kick_cat);
+};
+
+template<>
+struct yorel::yomm2::closed_definitions<indexed_type_id::meet> {
+    static constexpr auto functions = std::make_tuple(
+        &indexed_type_id::meet_animals, &indexed_type_id::meet_dog_cat,
+        &indexed_type_id::meet_dog_animal, &indexed_type_id::meet_animal_cat);
+};
+
+namespace indexed_type_id {
+
+BOOST_AUTO_TEST_CASE(custom_rtti_indexed) {
+    // no 'update'
+    static_assert(kick::closed_table<>::value.size() == 4);
+    static_assert(meet::closed_table<>::value.size() == 16);
+
+    Dog snoopy("Snoopy");
+    Cat sylvester("Sylvester");
+    Animal &a = snoopy, &b = sylvester;
+
+    BOOST_TEST(kick::fn(a) == "Snoopy barks.");
+    BOOST_TEST(kick::fn(b) == "Sylvester hisses.");
+
+    BOOST_TEST(meet::fn(a, a) == "sniff");
+    BOOST_TEST(meet::fn(b, b) == "wait");
+    BOOST_TEST(meet::fn(b, a) == "ignore");
+    // (Dog, Cat), (Dog, Animal) and (Animal, Cat) all apply; (Dog, Cat) is the
+    // most specific
+    BOOST_TEST(meet::fn(a, b) == "chase");
+
+    Animal animal("Animal");
+    BOOST_CHECK_THROW(kick::fn(animal), resolution_error);
+    BOOST_TEST(meet::fn(animal, b) == "wait");
+}
+
+} // namespace indexed_type_id
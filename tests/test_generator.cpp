@@ -22,6 +22,15 @@ static_assert(
     detail::has_static_offsets<method_class(
         void, identify, (virtual_<Property&>, std::ostream&))>::value);
 
+static_assert(!detail::has_static_guard<method_class(
+                  void, kick, (virtual_<Animal&>, std::ostream&))>::value);
+static_assert(detail::static_guard<method_class(
+                  void, pet, (virtual_<Animal&>, std::ostream&))>::function ==
+              &pet_dog);
+
+static_assert(detail::has_dispatch_function<describe>::value);
+static_assert(detail::has_dispatch_function<encounter>::value);
+
 #define BOOST_TEST_MODULE test_generator
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/data/test_case.hpp>
@@ -73,4 +82,32 @@ BOOST_AUTO_TEST_CASE(test_generator) {
     os.str("");
     identify(*dog, os);
     BOOST_TEST(os.str() == "Bob's dog");
+
+    os.str("");
+    pet(*dog, os);
+    BOOST_TEST(os.str() == "wag tail");
+
+    os.str("");
+    pet(*cat, os);
+    BOOST_TEST(os.str() == "purr");
+}
+
+BOOST_AUTO_TEST_CASE(test_dispatch_functions) {
+    auto report = update<closed_policy>().report;
+    BOOST_TEST(report.class_indices > 0u);
+
+    Animal animal;
+    Cat cat;
+    Dog dog;
+    DomesticDog domestic_dog("Bob");
+
+    BOOST_TEST(describe::fn(cat) == "cat");
+    BOOST_TEST(describe::fn(dog) == "dog");
+    BOOST_TEST(describe::fn(domestic_dog) == "dog");
+    BOOST_CHECK_THROW(describe::fn(animal), resolution_error);
+
+    BOOST_TEST(encounter::fn(dog, cat) == "chase");
+    BOOST_TEST(encounter::fn(domestic_dog, cat) == "chase");
+    BOOST_TEST(encounter::fn(cat, dog) == "ignore");
+    BOOST_TEST(encounter::fn(animal, animal) == "ignore");
 }
@@ -33,3 +33,40 @@ define_method(void, identify, (DomesticDog & animal, std::ostream& os)) {
     os << animal.owner << "'s"
        << " dog";
 }
+
+void pet_dog(Dog& dog, std::ostream& os) {
+    os << "wag tail";
+}
+
+void pet_cat(Cat& cat, std::ostream& os) {
+    os << "purr";
+}
+
+YOMM2_STATIC(method_class(
+    void, pet, (virtual_<Animal&>, std::ostream&))::add_function<pet_dog>);
+YOMM2_STATIC(method_class(
+    void, pet, (virtual_<Animal&>, std::ostream&))::add_function<pet_cat>);
+
+register_classes(
+    Animal, Cat, Dog, Property, DomesticCat, DomesticDog, closed_policy);
+
+std::string describe_cat(Cat& cat) {
+    return "cat";
+}
+
+std::string describe_dog(Dog& dog) {
+    return "dog";
+}
+
+std::string encounter_animals(Animal& a, Animal& b) {
+    return "ignore";
+}
+
+std::string encounter_dog_cat(Dog& dog, Cat& cat) {
+    return "chase";
+}
+
+YOMM2_STATIC(describe::add_function<describe_cat>);
+YOMM2_STATIC(describe::add_function<describe_dog>);
+YOMM2_STATIC(encounter::add_function<encounter_animals>);
+YOMM2_STATIC(encounter::add_function<encounter_dog_cat>);
@@ -51,6 +51,42 @@ declare_method(void, kick, (virtual_<Animal&>, std::ostream&));
 declare_method(
     void, meet, (virtual_<Animal&>, virtual_<Animal&>, std::ostream&));
 declare_method(void, identify, (virtual_<Property&>, std::ostream&));
+declare_method(void, pet, (virtual_<Animal&>, std::ostream&));
+
+// 'pet' is defined with named functions, thus calls to it can be
+// devirtualized.
+void pet_dog(Dog& dog, std::ostream& os);
+void pet_cat(Cat& cat, std::ostream& os);
+
+#if __has_include("test_generator_guards.hpp")
+#include "test_generator_guards.hpp"
+#endif
+
+// The same classes, in a hierarchy that is closed when the program is built.
+// Calls are dispatched by the functions written by
+// 'generator::write_dispatch_functions'.
+struct closed_policy
+    : throw_policy::rebind<closed_policy>::add<
+          yorel::yomm2::policy::basic_dispatch_functions<closed_policy>> {};
+
+using describe = yorel::yomm2::method<
+    struct describe_, std::string(yorel::yomm2::virtual_<Animal&>),
+    closed_policy>;
+
+using encounter = yorel::yomm2::method<
+    struct encounter_,
+    std::string(
+        yorel::yomm2::virtual_<Animal&>, yorel::yomm2::virtual_<Animal&>),
+    closed_policy>;
+
+std::string describe_cat(Cat& cat);
+std::string describe_dog(Dog& dog);
+std::string encounter_animals(Animal& a, Animal& b);
+std::string encounter_dog_cat(Dog& dog, Cat& cat);
+
+#if __has_include("test_generator_dispatch.hpp")
+#include "test_generator_dispatch.hpp"
+#endif
 
 #ifdef _MSC_VER
 // Because MSC is believes that forward declaring with 'struct' or 'class' makes
@@ -6,6 +6,7 @@
 #include "test_generator_domain.hpp"
 
 #include <iostream>
+#include <sstream>
 #include <yorel/yomm2/generator.hpp>
 
 int main(int argc, char* argv[]) {
@@ -23,5 +24,29 @@ int main(int argc, char* argv[]) {
     std::ofstream tables("test_generator_tables.hpp");
     generator.encode_dispatch_data(compiler, tables);
 
+    // A call profile, as 'basic_call_counter' would record it, in which most
+    // calls to 'kick' and 'pet' are for dogs. The definitions of 'kick' are
+    // not named functions, so only 'pet' gets a guard.
+    auto name = [](const std::type_info& type) {
+        return boost::core::demangle(type.name());
+    };
+
+    std::stringstream profile;
+
+    for (auto method :
+         {name(typeid(method_class(
+              void, kick, (virtual_<Animal&>, std::ostream&)))),
+          name(typeid(method_class(
+              void, pet, (virtual_<Animal&>, std::ostream&))))}) {
+        profile << method << "\t" << name(typeid(DomesticDog)) << "\t90\n"
+                << method << "\t" << name(typeid(DomesticCat)) << "\t10\n";
+    }
+
+    std::ofstream guards("test_generator_guards.hpp");
+    generator.write_static_guards(profile, guards);
+
+    std::ofstream dispatch("test_generator_dispatch.hpp");
+    generator.write_dispatch_functions(update<closed_policy>(), dispatch);
+
     return 0;
 }
@@ -24,6 +24,8 @@ struct indirect {};
 struct Player {
     virtual ~Player() {
     }
+
+    int refs = 0;
 };
 
 struct Warrior : Player {};
@@ -34,10 +36,45 @@ struct Bear : Player {};
 struct Object {
     virtual ~Object() {
     }
+
+    int refs = 0;
 };
 
 struct Axe : Object {};
 
+// reference counting for boost::intrusive_ptr
+
+std::size_t add_ref_calls;
+
+template<class Class>
+void add_ref(Class* obj) {
+    ++obj->refs;
+    ++add_ref_calls;
+}
+
+template<class Class>
+void release(Class* obj) {
+    if (--obj->refs == 0) {
+        delete obj;
+    }
+}
+
+void intrusive_ptr_add_ref(Player* obj) {
+    add_ref(obj);
+}
+
+void intrusive_ptr_release(Player* obj) {
+    release(obj);
+}
+
+void intrusive_ptr_add_ref(Object* obj) {
+    add_ref(obj);
+}
+
+void intrusive_ptr_release(Object* obj) {
+    release(obj);
+}
+
 template<class VirtualBearPtr>
 auto kick_bear(VirtualBearPtr) {
     return std::string("growl");
@@ -54,7 +91,13 @@ struct indirect_test_policy : test_policy_<Key> {
 };
 
 template<int Key>
-using policy_types = types<test_policy_<Key>, indirect_test_policy<Key>>;
+struct compact_test_policy
+    : test_policy_<Key>::template rebind<compact_test_policy<Key>>,
+      policy::compact_vptr {};
+
+template<int Key>
+using policy_types = types<
+    test_policy_<Key>, indirect_test_policy<Key>, compact_test_policy<Key>>;
 
 namespace YOMM2_GENSYM {
 
@@ -106,9 +149,17 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(
 
     update<Policy>();
 
+    // compact virtual_ptrs store an offset from the dispatch data, and
+    // survive a relocation of the tables
     BOOST_TEST(
         (virtual_cat_ptr._vptr() == Policy::template static_vptr<Bear>) ==
-        Policy::template has_facet<policy::indirect_vptr>);
+        (Policy::template has_facet<policy::indirect_vptr> ||
+         Policy::template has_facet<policy::compact_vptr>));
+
+    if constexpr (Policy::template has_facet<policy::compact_vptr>) {
+        static_assert(sizeof(vptr_cat) == sizeof(std::uintptr_t));
+        BOOST_TEST(&*virtual_cat_ptr == &bear);
+    }
 }
 } // namespace YOMM2_GENSYM
 
@@ -196,6 +247,230 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(
     BOOST_TEST(kick::fn(bear) == "growl");
 
     BOOST_TEST(fight::fn(warrior, axe, bear) == "kill bear");
+
+    auto shared_bear = std::make_shared<Bear>();
+    virtual_shared_ptr<Player, Policy> from_lvalue(shared_bear);
+    BOOST_TEST(
+        (from_lvalue._vptr() == Policy::template static_vptr<Bear>));
+    BOOST_TEST(from_lvalue.get() == shared_bear);
 }
 
 } // namespace test_virtual_shared_ptr_dispatch
+
+namespace test_intrusive_vptr {
+
+struct intrusive_policy
+    : policy::basic_policy<
+          intrusive_policy, policy::std_rtti,
+          policy::basic_intrusive_vptr<intrusive_policy>> {};
+
+struct indirect_intrusive_policy
+    : policy::basic_policy<
+          indirect_intrusive_policy, policy::std_rtti,
+          policy::basic_intrusive_vptr<indirect_intrusive_policy>,
+          policy::indirect_vptr> {};
+
+template<class Policy>
+struct Animal : with_vptr<Animal<Policy>, Policy> {
+    virtual ~Animal() {
+    }
+};
+
+template<class Policy>
+struct Dog : Animal<Policy>, with_vptr<Dog<Policy>, Animal<Policy>> {};
+
+template<class Policy>
+struct Puppy : Dog<Policy>, with_vptr<Puppy<Policy>, Dog<Policy>> {};
+
+template<class Class>
+std::string name(const Class&) {
+    if constexpr (std::is_same_v<Class, Puppy<typename Class::yomm2_policy>>) {
+        return "puppy";
+    } else if constexpr (std::is_same_v<
+                             Class, Dog<typename Class::yomm2_policy>>) {
+        return "dog";
+    } else {
+        return "animal";
+    }
+}
+
+template<class Class>
+std::string vp_name(virtual_ptr<Class, typename Class::yomm2_policy> ptr) {
+    return name(*ptr);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(
+    test_intrusive_vptr, Policy,
+    BOOST_IDENTITY_TYPE((types<intrusive_policy, indirect_intrusive_policy>))) {
+    static use_classes<Animal<Policy>, Dog<Policy>, Puppy<Policy>, Policy>
+        YOMM2_GENSYM;
+
+    using by_ref = method<
+        void, std::string(virtual_<const Animal<Policy>&>), Policy>;
+    static typename by_ref::template add_function<name<Animal<Policy>>>
+        YOMM2_GENSYM;
+    static typename by_ref::template add_function<name<Dog<Policy>>>
+        YOMM2_GENSYM;
+    static typename by_ref::template add_function<name<Puppy<Policy>>>
+        YOMM2_GENSYM;
+
+    using by_vptr = method<
+        void, std::string(virtual_ptr<const Animal<Policy>, Policy>), Policy>;
+    static typename by_vptr::template add_function<
+        vp_name<const Animal<Policy>>>
+        YOMM2_GENSYM;
+    static typename by_vptr::template add_function<vp_name<const Dog<Policy>>>
+        YOMM2_GENSYM;
+
+    update<Policy>();
+
+    Animal<Policy> animal;
+    Dog<Policy> dog;
+    Puppy<Policy> puppy;
+
+    BOOST_TEST(by_ref::fn(animal) == "animal");
+    BOOST_TEST(by_ref::fn(dog) == "dog");
+    BOOST_TEST(by_ref::fn(puppy) == "puppy");
+
+    BOOST_TEST(
+        (virtual_ptr<const Animal<Policy>, Policy>(puppy)._vptr() ==
+         Policy::template static_vptr<Puppy<Policy>>));
+    BOOST_TEST(by_vptr::fn(puppy) == "dog");
+
+    // copying an object slices the vptr along with it
+    Animal<Policy> sliced(puppy);
+    BOOST_TEST(by_ref::fn(sliced) == "animal");
+
+    if constexpr (Policy::template has_facet<policy::indirect_vptr>) {
+        // objects created before update() see the new tables
+        auto data = Policy::dispatch_data.data();
+
+        while (data == Policy::dispatch_data.data()) {
+            Policy::dispatch_data.resize(2 * Policy::dispatch_data.size());
+        }
+
+        update<Policy>();
+
+        BOOST_TEST(Policy::dispatch_data.data() != data);
+        BOOST_TEST(by_ref::fn(puppy) == "puppy");
+        BOOST_TEST(by_vptr::fn(dog) == "dog");
+    }
+}
+
+} // namespace test_intrusive_vptr
+
+namespace test_virtual_unique_ptr_dispatch {
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(
+    test_virtual_ptr_dispatch, Policy, policy_types<__COUNTER__>) {
+
+    static use_classes<Player, Warrior, Object, Axe, Bear, Policy> YOMM2_GENSYM;
+
+    using kick =
+        method<void, std::string(virtual_unique_ptr<Player, Policy>), Policy>;
+
+    static typename kick::template add_function<
+        kick_bear<virtual_unique_ptr<Player, Policy>>>
+        YOMM2_GENSYM;
+
+    using fight = method<
+        void,
+        std::string(
+            virtual_unique_ptr<Player, Policy>,
+            virtual_unique_ptr<Object, Policy>,
+            virtual_unique_ptr<Player, Policy>),
+        Policy>;
+
+    static typename fight::template add_function<fight_bear<
+        virtual_unique_ptr<Player, Policy>, virtual_unique_ptr<Object, Policy>,
+        virtual_unique_ptr<Player, Policy>>>
+        YOMM2_GENSYM;
+
+    update<Policy>();
+
+    BOOST_TEST(kick::fn(make_virtual_unique<Bear, Policy>()) == "growl");
+
+    BOOST_TEST(
+        fight::fn(
+            make_virtual_unique<Warrior, Policy>(),
+            make_virtual_unique<Axe, Policy>(),
+            make_virtual_unique<Bear, Policy>()) == "kill bear");
+
+    virtual_unique_ptr<Player, Policy> player(std::make_unique<Bear>());
+    BOOST_TEST((player._vptr() == Policy::template static_vptr<Bear>));
+
+    auto object = &*player;
+    auto bear =
+        std::move(player).template cast<virtual_unique_ptr<Bear, Policy>>();
+    BOOST_TEST(&*bear == object);
+    BOOST_TEST(!player.get());
+    BOOST_TEST((bear._vptr() == Policy::template static_vptr<Bear>));
+
+    virtual_unique_ptr<Player, Policy> upcast(std::move(bear));
+    BOOST_TEST(&*upcast == object);
+    BOOST_TEST(kick::fn(std::move(upcast)) == "growl");
+}
+
+} // namespace test_virtual_unique_ptr_dispatch
+
+namespace test_virtual_intrusive_ptr_dispatch {
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(
+    test_virtual_ptr_dispatch, Policy, policy_types<__COUNTER__>) {
+
+    static use_classes<Player, Warrior, Object, Axe, Bear, Policy> YOMM2_GENSYM;
+
+    using kick = method<
+        void, std::string(virtual_intrusive_ptr<Player, Policy>), Policy>;
+
+    static typename kick::template add_function<
+        kick_bear<virtual_intrusive_ptr<Player, Policy>>>
+        YOMM2_GENSYM;
+
+    using fight = method<
+        void,
+        std::string(
+            virtual_intrusive_ptr<Player, Policy>,
+            virtual_intrusive_ptr<Object, Policy>,
+            virtual_intrusive_ptr<Player, Policy>),
+        Policy>;
+
+    static typename fight::template add_function<fight_bear<
+        virtual_intrusive_ptr<Player, Policy>,
+        virtual_intrusive_ptr<Object, Policy>,
+        virtual_intrusive_ptr<Player, Policy>>>
+        YOMM2_GENSYM;
+
+    update<Policy>();
+
+    boost::intrusive_ptr<Bear> bear(new Bear);
+    auto warrior = virtual_intrusive_ptr<Warrior, Policy>::final(
+        boost::intrusive_ptr<Warrior>(new Warrior));
+    auto axe = virtual_intrusive_ptr<Axe, Policy>::final(
+        boost::intrusive_ptr<Axe>(new Axe));
+
+    virtual_intrusive_ptr<Player, Policy> player(bear);
+    BOOST_TEST(bear->refs == 2);
+    BOOST_TEST((player._vptr() == Policy::template static_vptr<Bear>));
+
+    BOOST_TEST(kick::fn(player) == "growl");
+    BOOST_TEST(fight::fn(warrior, axe, player) == "kill bear");
+    BOOST_TEST(bear->refs == 2);
+
+    // moving the pointers through the call does not touch the counts
+    auto calls = add_ref_calls;
+    BOOST_TEST(
+        fight::fn(std::move(warrior), std::move(axe), std::move(player)) ==
+        "kill bear");
+    BOOST_TEST(add_ref_calls == calls);
+    BOOST_TEST(bear->refs == 1);
+
+    virtual_intrusive_ptr<Player, Policy> moved(std::move(bear));
+    auto cast =
+        std::move(moved).template cast<virtual_intrusive_ptr<Bear, Policy>>();
+    BOOST_TEST(add_ref_calls == calls);
+    BOOST_TEST(cast->refs == 1);
+    BOOST_TEST(!moved.get());
+}
+
+} // namespace test_virtual_intrusive_ptr_dispatch